@@ -0,0 +1,250 @@
+/*
+ * Throughput of the CPU Bezier kernels (Bezier.hpp), the baseline for any
+ * change to them. Each benchmark samples a set of random rational curves or
+ * patches, for every degree and sample count, with:
+ *  - scalar: the same de Casteljau one coordinate at a time, no Eigen,
+ *  - simd: the Eigen kernels, a homogeneous point per register,
+ *  - threaded: the Eigen kernels run by parallelFor on every core,
+ * in float and double. items_per_second counts evaluated points.
+ *
+ * Usual Google Benchmark options, e.g.
+ *   bezier_bench --benchmark_filter=surface/float
+ *   bezier_bench --benchmark_out=bench.json --benchmark_out_format=json
+ * (the bench_json target does the latter).
+ */
+#include "Bezier.hpp"
+#include "Parallel.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr std::size_t CURVE_COUNT = 256;
+    constexpr std::size_t PATCH_COUNT = 16;
+    // points per worker job of the threaded benchmarks
+    constexpr std::size_t CURVES_PER_JOB = 16;
+    constexpr std::size_t PATCHES_PER_JOB = 1;
+
+    const std::vector<std::int64_t> DEGREES{1, 2, 3, 5, 8, 12, 16, 20};
+    const std::vector<std::int64_t> CURVE_SAMPLES{16, 256};
+    // per side of the grid
+    const std::vector<std::int64_t> PATCH_SAMPLES{4, 16};
+
+    enum class Kernel {
+        Scalar,
+        Simd,
+        Threaded
+    };
+
+    template <typename T>
+    using HPoints = std::vector<Homogeneous<T>, Eigen::aligned_allocator<Homogeneous<T>>>;
+
+    template <typename T>
+    using Points = std::vector<Point3<T>, Eigen::aligned_allocator<Point3<T>>>;
+
+    /**
+     * count random control points, weights in [0.5, 2], always the same.
+     */
+    template <typename T>
+    HPoints<T> randomControlPoints(std::size_t count) {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<T> coordinate(T(-1), T(1));
+        std::uniform_real_distribution<T> weight(T(0.5), T(2));
+
+        HPoints<T> points(count);
+        for (auto& point : points) {
+            const Point3<T> position(coordinate(random), coordinate(random),
+                                     coordinate(random));
+            point = toHomogeneous(position, weight(random));
+        }
+        return points;
+    }
+
+    // the scalar reference, written without Eigen
+
+    template <typename T>
+    struct ScalarPoint {
+        T c[4];
+    };
+
+    template <typename T>
+    ScalarPoint<T> scalarDeCasteljau(const Homogeneous<T>* cp, std::size_t count,
+                                     T t) {
+        ScalarPoint<T> points[BEZIER_MAX_CP];
+        for (std::size_t i = 0; i < count; ++i) {
+            for (int k = 0; k < 4; ++k) {
+                points[i].c[k] = cp[i][k];
+            }
+        }
+
+        const T s = T(1) - t;
+        for (std::size_t n = count - 1; n > 0; --n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (int k = 0; k < 4; ++k) {
+                    points[i].c[k] = s * points[i].c[k] + t * points[i + 1].c[k];
+                }
+            }
+        }
+        return points[0];
+    }
+
+    template <typename T>
+    void scalarSampleCurve(const Homogeneous<T>* cp, std::size_t count,
+                           std::size_t samples, Point3<T>* out) {
+        const T step = T(1) / T(samples - 1);
+        for (std::size_t i = 0; i < samples; ++i) {
+            const auto p = scalarDeCasteljau(cp, count, T(i) * step);
+            for (int k = 0; k < 3; ++k) {
+                out[i][k] = p.c[k] / p.c[3];
+            }
+        }
+    }
+
+    template <typename T>
+    void scalarSamplePatch(const Homogeneous<T>* cp, std::size_t countU, std::size_t countV,
+                           std::size_t samplesU, std::size_t samplesV, Point3<T>* out) {
+        const T stepU = T(1) / T(samplesU - 1);
+        const T stepV = T(1) / T(samplesV - 1);
+
+        Homogeneous<T> columns[BEZIER_MAX_CP];
+        for (std::size_t j = 0; j < samplesV; ++j) {
+            const T v = T(j) * stepV;
+            for (std::size_t iu = 0; iu < countU; ++iu) {
+                const auto p = scalarDeCasteljau(cp + iu * countV, countV, v);
+                for (int k = 0; k < 4; ++k) {
+                    columns[iu][k] = p.c[k];
+                }
+            }
+            for (std::size_t i = 0; i < samplesU; ++i) {
+                const auto p = scalarDeCasteljau(columns, countU, T(i) * stepU);
+                for (int k = 0; k < 3; ++k) {
+                    out[j * samplesU + i][k] = p.c[k] / p.c[3];
+                }
+            }
+        }
+    }
+
+    template <typename T>
+    void curves(benchmark::State& state, Kernel kernel) {
+        const auto count = static_cast<std::size_t>(state.range(0)) + 1;
+        const auto samples = static_cast<std::size_t>(state.range(1));
+        const auto controlPoints = randomControlPoints<T>(CURVE_COUNT * count);
+        Points<T> out(CURVE_COUNT * samples);
+
+        auto sample = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c < end; ++c) {
+                if (kernel == Kernel::Scalar) {
+                    scalarSampleCurve(controlPoints.data() + c * count, count, samples,
+                                      out.data() + c * samples);
+                } else {
+                    sampleCurve(controlPoints.data() + c * count, count, samples,
+                                out.data() + c * samples);
+                }
+            }
+        };
+
+        for (auto _ : state) {
+            if (kernel == Kernel::Threaded) {
+                parallelFor(CURVE_COUNT, CURVES_PER_JOB, 0,
+                            [&](std::size_t begin, std::size_t end, unsigned) {
+                                sample(begin, end);
+                            });
+            } else {
+                sample(0, CURVE_COUNT);
+            }
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()
+                                                          * CURVE_COUNT * samples));
+    }
+
+    template <typename T>
+    void patches(benchmark::State& state, Kernel kernel) {
+        const auto count = static_cast<std::size_t>(state.range(0)) + 1;
+        const auto side = static_cast<std::size_t>(state.range(1));
+        const auto controlPoints = randomControlPoints<T>(PATCH_COUNT * count * count);
+        Points<T> out(PATCH_COUNT * side * side);
+
+        auto sample = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t p = begin; p < end; ++p) {
+                const auto* cp = controlPoints.data() + p * count * count;
+                auto* grid = out.data() + p * side * side;
+                if (kernel == Kernel::Scalar) {
+                    scalarSamplePatch(cp, count, count, side, side, grid);
+                } else {
+                    samplePatch(cp, count, count, side, side, grid);
+                }
+            }
+        };
+
+        for (auto _ : state) {
+            if (kernel == Kernel::Threaded) {
+                parallelFor(PATCH_COUNT, PATCHES_PER_JOB, 0,
+                            [&](std::size_t begin, std::size_t end, unsigned) {
+                                sample(begin, end);
+                            });
+            } else {
+                sample(0, PATCH_COUNT);
+            }
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()
+                                                          * PATCH_COUNT * side * side));
+    }
+
+    const char* kernelName(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::Scalar:
+                return "scalar";
+            case Kernel::Simd:
+                return "simd";
+            default:
+                return "threaded";
+        }
+    }
+
+    template <typename T>
+    void registerType(const std::string& type) {
+        for (const Kernel kernel : {Kernel::Scalar, Kernel::Simd, Kernel::Threaded}) {
+            auto* curve = benchmark::RegisterBenchmark(
+                    ("curve/" + type + "/" + kernelName(kernel)).c_str(),
+                    curves<T>, kernel
+            );
+            curve->ArgsProduct({DEGREES, CURVE_SAMPLES})
+                    ->ArgNames({"degree", "samples"});
+
+            auto* patch = benchmark::RegisterBenchmark(
+                    ("surface/" + type + "/" + kernelName(kernel)).c_str(),
+                    patches<T>, kernel
+            );
+            patch->ArgsProduct({DEGREES, PATCH_SAMPLES})
+                    ->ArgNames({"degree", "samples"});
+
+            // the workers are other threads, the CPU time of the main one
+            // says nothing
+            if (kernel == Kernel::Threaded) {
+                curve->UseRealTime();
+                patch->UseRealTime();
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    registerType<float>("float");
+    registerType<double>("double");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,57 @@
+# Writes OUTPUT, a C++ source embedding every file of RESOURCE_DIR/SUBDIR as
+# a constexpr string, sorted by path for findEmbeddedResource.
+#
+# cmake -DRESOURCE_DIR=<dir> -DSUBDIR=<subdir> -DOUTPUT=<file> -P EmbedResources.cmake
+
+file(GLOB_RECURSE files RELATIVE ${RESOURCE_DIR} ${RESOURCE_DIR}/${SUBDIR}/*)
+list(SORT files)
+
+set(arrays "")
+set(table "")
+set(index 0)
+foreach(file ${files})
+    file(READ ${RESOURCE_DIR}/${file} hex HEX)
+    # 32 bytes per line, each byte as a \x escape
+    string(REGEX REPLACE "(................................................................)" "\\1\n" hex "${hex}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "\\\\x\\1" hex "${hex}")
+    string(REGEX REPLACE "\n$" "" hex "${hex}")
+    string(REPLACE "\n" "\"\n        \"" hex "${hex}")
+
+    set(arrays "${arrays}constexpr char resource${index}[] =\n        \"${hex}\";\n\n")
+    set(table "${table}        {\"${file}\", resource${index}, sizeof(resource${index}) - 1},\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+set(content "// Generated by cmake/EmbedResources.cmake from resources/${SUBDIR}, do not edit.
+
+#include \"EmbeddedResources.hpp\"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+${arrays}constexpr EmbeddedResource resources[] = {
+${table}};
+
+} // namespace
+
+const EmbeddedResource* findEmbeddedResource(const std::string& path) {
+    const auto end = resources + sizeof(resources) / sizeof(resources[0]);
+    const auto it = std::lower_bound(
+            resources, end, path,
+            [](const EmbeddedResource& resource, const std::string& key) {
+                return std::strcmp(resource.path, key.c_str()) < 0;
+            }
+    );
+    return it != end && path == it->path ? it : nullptr;
+}
+")
+
+# only touch the output when it changes, to avoid useless rebuilds
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+endif()
+if(NOT "${previous}" STREQUAL "${content}")
+    file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -0,0 +1,124 @@
+#ifndef BEZIER_BEZIER_HPP
+#define BEZIER_BEZIER_HPP
+
+#include <Eigen/Core>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*
+ * CPU evaluation of (rational) Bezier curves and rectangular patches.
+ *
+ * Control points are homogeneous: (w x, w y, w z, w). de Casteljau is run on
+ * the 4D points and the division by w is done once at the end, so polynomial
+ * curves are the special case w = 1. With float, a 4D point is one SSE
+ * register and every interpolation step of the algorithm is a single
+ * vectorized multiply-add.
+ *
+ * Patch control points use the same layout as the shaders: the point (iu, iv)
+ * is at index iu * countV + iv.
+ */
+constexpr std::size_t BEZIER_MAX_CP = 64;
+
+template <typename T>
+using Homogeneous = Eigen::Matrix<T, 4, 1>;
+
+template <typename T>
+using Point3 = Eigen::Matrix<T, 3, 1>;
+
+template <typename T>
+inline Homogeneous<T> toHomogeneous(const Point3<T>& p, T weight = T(1)) {
+    return Homogeneous<T>(p.x() * weight, p.y() * weight, p.z() * weight, weight);
+}
+
+template <typename T>
+inline Point3<T> fromHomogeneous(const Homogeneous<T>& p) {
+    return p.template head<3>() / p.w();
+}
+
+/**
+ * de Casteljau on count points read with the given stride. Works on any
+ * Eigen fixed size vector (the point type is deduced).
+ */
+template <typename Point>
+inline Point deCasteljau(const Point* cp, std::size_t count,
+                         typename Point::Scalar t, std::size_t stride = 1) {
+    assert(count > 0 && count <= BEZIER_MAX_CP);
+    using T = typename Point::Scalar;
+
+    Point points[BEZIER_MAX_CP];
+    for (std::size_t i = 0; i < count; ++i) {
+        points[i] = cp[i * stride];
+    }
+
+    const T s = T(1) - t;
+    for (std::size_t n = count - 1; n > 0; --n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            points[i] = s * points[i] + t * points[i + 1];
+        }
+    }
+
+    return points[0];
+}
+
+template <typename T>
+inline Homogeneous<T> evaluateCurve(const Homogeneous<T>* cp, std::size_t count,
+                                    T t) {
+    return deCasteljau(cp, count, t);
+}
+
+template <typename T>
+inline Homogeneous<T> evaluatePatch(const Homogeneous<T>* cp,
+                                    std::size_t countU, std::size_t countV,
+                                    T u, T v) {
+    assert(countU <= BEZIER_MAX_CP);
+
+    Homogeneous<T> columns[BEZIER_MAX_CP];
+    for (std::size_t iu = 0; iu < countU; ++iu) {
+        columns[iu] = deCasteljau(cp + iu * countV, countV, v);
+    }
+    return deCasteljau(columns, countU, u);
+}
+
+/**
+ * Evaluate a curve on samples uniform parameters (samples >= 2) and write the
+ * projected points in out.
+ */
+template <typename T>
+void sampleCurve(const Homogeneous<T>* cp, std::size_t count,
+                 std::size_t samples, Point3<T>* out) {
+    const T step = T(1) / T(samples - 1);
+    for (std::size_t i = 0; i < samples; ++i) {
+        out[i] = fromHomogeneous(evaluateCurve(cp, count, T(i) * step));
+    }
+}
+
+/**
+ * Evaluate a patch on a samplesU x samplesV uniform grid (both >= 2).
+ * The v direction is reduced once per grid column and shared by every u
+ * sample. out[j * samplesU + i] is the point at (u_i, v_j).
+ */
+template <typename T>
+void samplePatch(const Homogeneous<T>* cp, std::size_t countU, std::size_t countV,
+                 std::size_t samplesU, std::size_t samplesV, Point3<T>* out) {
+    assert(countU <= BEZIER_MAX_CP);
+
+    const T stepU = T(1) / T(samplesU - 1);
+    const T stepV = T(1) / T(samplesV - 1);
+
+    Homogeneous<T> columns[BEZIER_MAX_CP];
+    for (std::size_t j = 0; j < samplesV; ++j) {
+        const T v = T(j) * stepV;
+        for (std::size_t iu = 0; iu < countU; ++iu) {
+            columns[iu] = deCasteljau(cp + iu * countV, countV, v);
+        }
+        for (std::size_t i = 0; i < samplesU; ++i) {
+            out[j * samplesU + i] = fromHomogeneous(
+                    deCasteljau(columns, countU, T(i) * stepU)
+            );
+        }
+    }
+}
+
+#endif //BEZIER_BEZIER_HPP
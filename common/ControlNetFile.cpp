@@ -0,0 +1,230 @@
+#include "ControlNetFile.hpp"
+
+#include "Bezier.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+        bytes(nullptr),
+        length(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE),
+        mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Unable to open file '" << path << "'" << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle, &fileSize);
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY,
+                                       0, 0, nullptr);
+    if (mappingHandle != nullptr) {
+        bytes = static_cast<const unsigned char*>(
+                MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)
+        );
+    }
+    if (bytes == nullptr) {
+        std::cerr << "Unable to map file '" << path << "'" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+    }
+    bytes = nullptr;
+    length = 0;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Unable to open file '" << path << "'" << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<std::size_t>(st.st_size);
+
+    void* ptr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        std::cerr << "Unable to map file '" << path << "'" << std::endl;
+        length = 0;
+        return false;
+    }
+
+    // read once from front to back by the upload
+    madvise(ptr, length, MADV_SEQUENTIAL);
+    bytes = static_cast<const unsigned char*>(ptr);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) {
+        munmap(const_cast<unsigned char*>(bytes), length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
+
+
+bool ControlNetFile::open(const std::string& path) {
+    if (!file.open(path)) {
+        return false;
+    }
+
+    const auto fail = [&](const char* reason) {
+        std::cerr << "Invalid control net file '" << path << "': "
+                  << reason << std::endl;
+        file.close();
+        return false;
+    };
+
+    if (file.size() < sizeof(ControlNetHeader)) {
+        return fail("truncated header");
+    }
+    const auto& h = header();
+    if (std::memcmp(h.magic, CONTROL_NET_MAGIC, sizeof(h.magic)) != 0) {
+        return fail("bad magic");
+    }
+    if (h.version != CONTROL_NET_VERSION) {
+        return fail("unsupported version");
+    }
+    if (h.pointStride != sizeof(ControlPoint)) {
+        return fail("unsupported control point format");
+    }
+    if (h.patchTableOffset % alignof(PatchRecord) != 0
+        || h.pointsOffset % alignof(ControlPoint) != 0) {
+        return fail("misaligned sections");
+    }
+    if (h.patchTableOffset > file.size()
+        || h.patchCount > (file.size() - h.patchTableOffset) / sizeof(PatchRecord)
+        || h.pointsOffset > file.size()
+        || h.pointCount > (file.size() - h.pointsOffset) / sizeof(ControlPoint)) {
+        return fail("truncated data");
+    }
+
+    const PatchRecord* table = patches();
+    for (std::size_t i = 0; i < h.patchCount; ++i) {
+        const auto& p = table[i];
+        if (p.countU == 0 || p.countV == 0
+            || p.countU > BEZIER_MAX_CP || p.countV > BEZIER_MAX_CP) {
+            return fail("invalid patch size");
+        }
+        // 64-bit product, count() wraps for large sizes
+        if (std::uint64_t(p.first) + std::uint64_t(p.countU) * p.countV > h.pointCount) {
+            return fail("patch out of the point range");
+        }
+    }
+    return true;
+}
+
+bool ControlNetFile::read(const std::string& path, PatchPool& pool,
+                          std::size_t maxCpuPoints) {
+    ControlNetFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    pool.assign(file.patches(), file.patchCount(),
+                file.points(), file.pointCount(),
+                file.pointCount() <= maxCpuPoints);
+    return true;
+}
+
+bool ControlNetFile::write(const std::string& path, const PatchPool& pool) {
+    const auto& records = pool.patches();
+    const auto& points = pool.controlPoints().points();
+    if (!pool.isResident()) {
+        std::cerr << "Control net is not resident in memory, cannot save it"
+                  << std::endl;
+        return false;
+    }
+
+    ControlNetHeader h{};
+    std::memcpy(h.magic, CONTROL_NET_MAGIC, sizeof(h.magic));
+    h.version = CONTROL_NET_VERSION;
+    h.pointStride = sizeof(ControlPoint);
+    h.patchCount = records.size();
+    h.pointCount = points.size();
+    h.patchTableOffset = sizeof(ControlNetHeader);
+    const std::uint64_t tableEnd = h.patchTableOffset
+                                   + h.patchCount * sizeof(PatchRecord);
+    h.pointsOffset = (tableEnd + 63) & ~std::uint64_t(63);
+
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (out == nullptr) {
+        std::cerr << "Unable to write file '" << path << "'" << std::endl;
+        return false;
+    }
+
+    static const char padding[64] = {};
+    bool ok = std::fwrite(&h, sizeof(h), 1, out) == 1;
+    ok = ok && std::fwrite(records.data(), sizeof(PatchRecord),
+                           records.size(), out) == records.size();
+    ok = ok && std::fwrite(padding, 1, h.pointsOffset - tableEnd, out)
+               == h.pointsOffset - tableEnd;
+    ok = ok && std::fwrite(points.data(), sizeof(ControlPoint),
+                           points.size(), out) == points.size();
+    ok = (std::fclose(out) == 0) && ok;
+
+    if (!ok) {
+        std::cerr << "Error while writing file '" << path << "'" << std::endl;
+    }
+    return ok;
+}
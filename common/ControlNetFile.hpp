@@ -0,0 +1,107 @@
+#ifndef BEZIER_CONTROL_NET_FILE_HPP
+#define BEZIER_CONTROL_NET_FILE_HPP
+
+#include "PatchPool.hpp"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Binary control net container (.cnet), native endianness:
+ *
+ *   ControlNetHeader
+ *   PatchRecord  [patchCount]   at patchTableOffset
+ *   ControlPoint [pointCount]   at pointsOffset (aligned on 64 bytes)
+ *
+ * The points are stored in the GPU vertex format, so a mapped file is sent
+ * to the VBO as is.
+ */
+struct ControlNetHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t pointStride;
+    std::uint64_t patchCount;
+    std::uint64_t pointCount;
+    std::uint64_t patchTableOffset;
+    std::uint64_t pointsOffset;
+};
+
+constexpr char CONTROL_NET_MAGIC[8] = {'B', 'Z', 'C', 'N', 'E', 'T', '\0', '\0'};
+constexpr std::uint32_t CONTROL_NET_VERSION = 1;
+constexpr std::size_t CONTROL_NET_MAX_CPU_POINTS = 1u << 20;
+
+/**
+ * Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    inline const unsigned char* data() const { return bytes; }
+    inline std::size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes;
+    std::size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+/**
+ * Mapped .cnet file, only the header is read on open.
+ */
+class ControlNetFile {
+public:
+    ControlNetFile() = default;
+
+    /**
+     * Map the file and check its header and table bounds.
+     */
+    bool open(const std::string& path);
+
+    inline const ControlNetHeader& header() const {
+        return *reinterpret_cast<const ControlNetHeader*>(file.data());
+    }
+
+    inline std::size_t patchCount() const { return header().patchCount; }
+    inline std::size_t pointCount() const { return header().pointCount; }
+
+    inline const PatchRecord* patches() const {
+        return reinterpret_cast<const PatchRecord*>(
+                file.data() + header().patchTableOffset
+        );
+    }
+
+    inline const ControlPoint* points() const {
+        return reinterpret_cast<const ControlPoint*>(
+                file.data() + header().pointsOffset
+        );
+    }
+
+    /**
+     * Load a .cnet file in pool. The points are kept in memory (to be edited
+     * or saved) only when there are at most maxCpuPoints of them, otherwise
+     * they are sent from the mapping to the VBO without any copy.
+     */
+    static bool read(const std::string& path, PatchPool& pool,
+                     std::size_t maxCpuPoints = CONTROL_NET_MAX_CPU_POINTS);
+
+    /**
+     * Write the patches and points of pool in the .cnet format.
+     */
+    static bool write(const std::string& path, const PatchPool& pool);
+
+private:
+    MappedFile file;
+};
+
+#endif //BEZIER_CONTROL_NET_FILE_HPP
@@ -0,0 +1,208 @@
+#ifndef BEZIER_CONTROL_POINT_HPP
+#define BEZIER_CONTROL_POINT_HPP
+
+#include "easycppogl_src/vao.h"
+
+#include "VertexFormat.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace EZCOGL;
+
+enum ControlPointFlags : GLuint {
+    CP_NONE = 0u,
+    CP_SELECTED = 1u << 0
+};
+
+/**
+ * GPU vertex of a control point (24 bytes): position and rational weight
+ * read as one vec4, RGBA8 color and selection flags.
+ */
+struct ControlPoint {
+    GLVec3 position;
+    GLfloat weight;
+    GLubyte color[4];
+    GLuint flags;
+
+    ControlPoint() :
+            ControlPoint(GLVec3::Zero()) {
+    }
+
+    ControlPoint(const GLVec3& pos, GLfloat w = 1.f) :
+            position(pos),
+            weight(w),
+            color{0, 255, 0, 255},
+            flags(CP_NONE) {
+    }
+
+    ControlPoint(float x, float y, float z, GLfloat w = 1.f) :
+            ControlPoint(GLVec3{x, y, z}, w) {
+    }
+
+    /**
+     * (w x, w y, w z, w), the form used by the rational Bezier kernels.
+     */
+    inline GLVec4 homogeneous() const {
+        return {position.x() * weight, position.y() * weight,
+                position.z() * weight, weight};
+    }
+
+    inline bool selected() const {
+        return (flags & CP_SELECTED) != 0;
+    }
+
+    inline void setColor(GLubyte r, GLubyte g, GLubyte b, GLubyte a = 255) {
+        color[0] = r;
+        color[1] = g;
+        color[2] = b;
+        color[3] = a;
+    }
+};
+
+using ControlPointFormat = VertexFormat<
+        Attribute<0, 4>,                           // iPosition (xyz, weight)
+        Attribute<1, 4, GL_UNSIGNED_BYTE, true>,   // iColor
+        Attribute<2, 1, GL_UNSIGNED_INT>           // iFlags
+>;
+
+static_assert(sizeof(ControlPoint) == ControlPointFormat::stride,
+              "ControlPoint must match ControlPointFormat");
+
+/**
+ * CPU copy of a set of control points and its VBO/VAO. The whole set lives
+ * in a single buffer whatever the number of attributes, the layout only
+ * changes how the attributes are arranged inside of it.
+ */
+template <VertexLayout Layout = VertexLayout::Interleaved>
+class ControlPointBuffer {
+public:
+    ControlPointBuffer() :
+            vbo(nullptr),
+            vao(nullptr),
+            gpuCount(0),
+            gpuCapacity(0) {
+    }
+
+    inline std::vector<ControlPoint>& points() { return cpuPoints; }
+    inline const std::vector<ControlPoint>& points() const { return cpuPoints; }
+
+    inline ControlPoint& operator[](std::size_t i) { return cpuPoints[i]; }
+    inline const ControlPoint& operator[](std::size_t i) const { return cpuPoints[i]; }
+
+    inline std::size_t size() const { return cpuPoints.size(); }
+
+    inline const SP_VAO& getVao() const { return vao; }
+    inline const SP_VBO& getVbo() const { return vbo; }
+
+    /**
+     * (Re)allocate the GPU buffer and send every point.
+     */
+    void upload() {
+        const auto count = static_cast<GLuint>(cpuPoints.size());
+        if (!vbo || count != gpuCapacity) {
+            allocate(count);
+        }
+        gpuCount = count;
+        update(0, count);
+    }
+
+    /**
+     * Send only the points appended since the last upload. The GPU buffer
+     * grows geometrically, so streaming n points costs O(n) transfers.
+     */
+    void uploadAppended() {
+        const auto count = static_cast<GLuint>(cpuPoints.size());
+        if (!vbo || count > gpuCapacity) {
+            allocate(std::max(count, 2 * gpuCapacity));
+            gpuCount = count;
+            update(0, count);
+            return;
+        }
+        const GLuint first = gpuCount;
+        gpuCount = count;
+        update(first, count - first);
+    }
+
+    /**
+     * Allocate the GPU buffer and fill it straight from count external points
+     * (a mapped file for instance). No CPU copy is kept.
+     */
+    void uploadFrom(const ControlPoint* points, std::size_t count) {
+        cpuPoints.clear();
+        cpuPoints.shrink_to_fit();
+        allocate(static_cast<GLuint>(count));
+        gpuCount = static_cast<GLuint>(count);
+        send(points, 0, count);
+    }
+
+    /**
+     * Send the points [first, first + count) to the already allocated buffer.
+     */
+    void update(std::size_t first, std::size_t count) {
+        if (first + count > cpuPoints.size()) {
+            return;
+        }
+        send(cpuPoints.data() + first, first, count);
+    }
+
+    /**
+     * Number of points in the GPU buffer (the CPU copy may be empty), the
+     * VAO may be larger.
+     */
+    inline std::size_t gpuSize() const { return gpuCount; }
+
+private:
+    void allocate(GLuint capacity) {
+        constexpr std::size_t stride = ControlPointFormat::stride;
+        vbo = VBO::create(static_cast<GLuint>(stride / sizeof(GLfloat)));
+        vbo->allocate(capacity);
+        vao = VAO::create(vbo, capacity,
+                          ControlPointFormat::attributes(Layout, capacity));
+        gpuCapacity = capacity;
+    }
+
+    void send(const ControlPoint* points, std::size_t first, std::size_t count) {
+        constexpr std::size_t stride = ControlPointFormat::stride;
+        if (!vbo || count == 0 || first + count > gpuCapacity) {
+            return;
+        }
+
+        vbo->bind();
+        if (Layout == VertexLayout::Interleaved) {
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            static_cast<GLintptr>(first * stride),
+                            static_cast<GLsizeiptr>(count * stride),
+                            points);
+        } else {
+            const auto atts = ControlPointFormat::attributes(
+                    VertexLayout::Interleaved, gpuCapacity
+            );
+            const auto* src = reinterpret_cast<const GLubyte*>(points);
+            for (const auto& att : atts) {
+                const std::size_t bytes = att.size * glTypeSize(att.type);
+                staging.resize(count * bytes);
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::memcpy(staging.data() + i * bytes,
+                                src + i * stride + att.offset,
+                                bytes);
+                }
+                glBufferSubData(GL_ARRAY_BUFFER,
+                                static_cast<GLintptr>(att.offset * gpuCapacity + first * bytes),
+                                static_cast<GLsizeiptr>(staging.size()),
+                                staging.data());
+            }
+        }
+        VBO::unbind();
+    }
+
+    std::vector<ControlPoint> cpuPoints;
+    std::vector<GLubyte> staging;
+
+    SP_VBO vbo;
+    SP_VAO vao;
+    GLuint gpuCount;
+    GLuint gpuCapacity;
+};
+
+#endif //BEZIER_CONTROL_POINT_HPP
@@ -0,0 +1,21 @@
+#ifndef BEZIER_EMBEDDED_RESOURCES_HPP
+#define BEZIER_EMBEDDED_RESOURCES_HPP
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Resource file compiled into the binary (see cmake/EmbedResources.cmake).
+ */
+struct EmbeddedResource {
+    const char* path;   // relative to resources/, like "shaders/basic_vert.glsl"
+    const char* data;
+    std::size_t size;
+};
+
+/**
+ * nullptr if no resource was embedded for path.
+ */
+const EmbeddedResource* findEmbeddedResource(const std::string& path);
+
+#endif //BEZIER_EMBEDDED_RESOURCES_HPP
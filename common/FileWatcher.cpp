@@ -0,0 +1,140 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::time_t modificationTime(const std::string& path) {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 ? st.st_mtime : 0;
+    }
+
+#ifdef __linux__
+    std::string parentDirectory(const std::string& path) {
+        const auto slash = path.find_last_of('/');
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    // editors save in several steps (truncate, write, rename...), changes
+    // this close to the first one are reported together
+    constexpr int SETTLE_MS = 30;
+
+    bool waitReadable(int fd, int timeoutMs) {
+        pollfd pfd{fd, POLLIN, 0};
+        return poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & POLLIN);
+    }
+#endif
+}
+
+FileWatcher::FileWatcher(const std::string& root) :
+        root(root),
+        notifyFd(-1) {
+#ifdef __linux__
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0) {
+        std::cerr << "inotify unavailable, polling '" << root << "'"
+                  << std::endl;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (notifyFd >= 0) {
+        close(notifyFd);
+    }
+#endif
+}
+
+void FileWatcher::add(const std::string& path) {
+    std::lock_guard<std::mutex> lock(filesMutex);
+    if (!files.insert(path).second) {
+        return;
+    }
+    times[path] = modificationTime(root + '/' + path);
+
+#ifdef __linux__
+    if (notifyFd < 0) {
+        return;
+    }
+    const std::string directory = parentDirectory(path);
+    for (const auto& watched : directories) {
+        if (watched.second == directory) {
+            return;
+        }
+    }
+    const int wd = inotify_add_watch(notifyFd, (root + '/' + directory).c_str(),
+                                     IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        std::cerr << "Unable to watch '" << root << '/' << directory << "'"
+                  << std::endl;
+        return;
+    }
+    directories[wd] = directory;
+#endif
+}
+
+std::vector<std::string> FileWatcher::wait(int timeoutMs) {
+#ifdef __linux__
+    if (notifyFd < 0) {
+        return pollTimes(timeoutMs);
+    }
+
+    std::vector<std::string> changed;
+    if (!waitReadable(notifyFd, timeoutMs)) {
+        return changed;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t size = read(notifyFd, buffer, sizeof(buffer));
+        if (size <= 0) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(filesMutex);
+        for (ssize_t offset = 0; offset < size;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto directory = directories.find(event->wd);
+            if (event->len == 0 || directory == directories.end()) {
+                continue;
+            }
+            const std::string path = directory->second + event->name;
+            if (files.count(path)
+                && std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                changed.push_back(path);
+            }
+        }
+    }
+    return changed;
+#else
+    return pollTimes(timeoutMs);
+#endif
+}
+
+std::vector<std::string> FileWatcher::pollTimes(int timeoutMs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+
+    std::vector<std::string> changed;
+    std::lock_guard<std::mutex> lock(filesMutex);
+    for (const auto& path : files) {
+        const std::time_t time = modificationTime(root + '/' + path);
+        if (time != times[path]) {
+            times[path] = time;
+            changed.push_back(path);
+        }
+    }
+    return changed;
+}
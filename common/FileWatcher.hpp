@@ -0,0 +1,54 @@
+#ifndef BEZIER_FILE_WATCHER_HPP
+#define BEZIER_FILE_WATCHER_HPP
+
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Reports the modifications of a set of files below a root directory.
+ *
+ * On Linux the directories holding the files are watched with inotify, so
+ * the files replaced by a rename (as most editors save) are still seen.
+ * Elsewhere, or if inotify is not available, the modification times are
+ * polled.
+ */
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string& root);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Watch root/path, path being relative to the root. May be called while
+     * another thread waits.
+     */
+    void add(const std::string& path);
+
+    /**
+     * Wait at most timeoutMs for modifications and return the paths (as
+     * given to add) of the files modified since the last call.
+     */
+    std::vector<std::string> wait(int timeoutMs);
+
+private:
+    std::vector<std::string> pollTimes(int timeoutMs);
+
+    std::string root;
+
+    std::mutex filesMutex;
+    std::set<std::string> files;
+    std::map<std::string, std::time_t> times;
+
+    // inotify descriptor (-1 when polling) and watched directory of each
+    // watch descriptor, relative to the root
+    int notifyFd;
+    std::map<int, std::string> directories;
+};
+
+#endif //BEZIER_FILE_WATCHER_HPP
@@ -0,0 +1,114 @@
+#include "HiZPyramid.hpp"
+
+#include <algorithm>
+
+namespace {
+    constexpr GLuint WORKGROUP_SIZE = 8;
+
+    inline GLuint groups(GLsizei size) {
+        return (static_cast<GLuint>(size) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    }
+}
+
+HiZPyramid::HiZPyramid() :
+        texture(0),
+        levelWidth(0),
+        levelHeight(0),
+        levels(0) {
+}
+
+HiZPyramid::~HiZPyramid() {
+    release();
+}
+
+void HiZPyramid::release() {
+    program.reset();
+    if (texture) {
+        glDeleteTextures(1, &texture);
+    }
+    texture = 0;
+    levelWidth = levelHeight = 0;
+    levels = 0;
+}
+
+bool HiZPyramid::init(ShaderLibrary& library) {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 3)) {
+        return false;
+    }
+
+    program = library.create({
+        {GL_COMPUTE_SHADER, "shaders/hiz_reduce_comp.glsl"}
+    }, "hiz_reduce");
+    return available();
+}
+
+void HiZPyramid::allocate(GLsizei width, GLsizei height) {
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    levelWidth = width;
+    levelHeight = height;
+    levels = 0;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    for (GLsizei size = std::max(width, height); size > 0; size /= 2) {
+        ++levels;
+    }
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HiZPyramid::build(Texture2D& depth) {
+    if (!available()) {
+        return;
+    }
+    if (depth.width() != levelWidth || depth.height() != levelHeight) {
+        allocate(depth.width(), depth.height());
+    }
+    if (levels == 0) {
+        return;
+    }
+
+    program->bind();
+    set_uniform_value("uFromDepth", true);
+    set_uniform_value("uDepth", static_cast<int32_t>(depth.bind(0)));
+    glBindImageTexture(1, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute(groups(levelWidth), groups(levelHeight), 1);
+
+    set_uniform_value("uFromDepth", false);
+    GLsizei width = levelWidth;
+    GLsizei height = levelHeight;
+    for (GLint level = 1; level < levels; ++level) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindImageTexture(0, texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(groups(width), groups(height), 1);
+    }
+    // read by texelFetch in the culling pass
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    Texture2D::unbind_compute_in(0);
+    Texture2D::unbind_compute_out(1);
+    Texture2D::unbind();
+    ShaderProgram::unbind();
+}
+
+GLuint HiZPyramid::bind(GLuint unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    return unit;
+}
@@ -0,0 +1,61 @@
+#ifndef BEZIER_HIZ_PYRAMID_HPP
+#define BEZIER_HIZ_PYRAMID_HPP
+
+#include "ShaderLibrary.hpp"
+
+#include "easycppogl_src/texture2d.h"
+
+/**
+ * Hierarchical depth buffer: a mipmapped R32F texture whose level 0 is a
+ * copy of a depth texture and each next level keeps the farthest depth of
+ * the texels it covers. Anything nearer than the value covering its screen
+ * rectangle may be visible, anything farther is hidden.
+ *
+ * Built by compute shaders (OpenGL 4.3), see available.
+ */
+class HiZPyramid {
+public:
+    HiZPyramid();
+    ~HiZPyramid();
+
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+    /**
+     * Build the reduction program, returns available().
+     */
+    bool init(ShaderLibrary& library);
+
+    inline bool available() const { return static_cast<bool>(program); }
+
+    /**
+     * Rebuild the pyramid from depth (a GL_DEPTH_COMPONENT texture).
+     */
+    void build(Texture2D& depth);
+
+    /**
+     * Bind the pyramid to a texture unit, returns the unit.
+     */
+    GLuint bind(GLuint unit) const;
+
+    /**
+     * Delete the program and the texture, while the context still exists.
+     */
+    void release();
+
+    inline bool empty() const { return levels == 0; }
+    inline GLsizei width() const { return levelWidth; }
+    inline GLsizei height() const { return levelHeight; }
+    inline GLint levelCount() const { return levels; }
+
+private:
+    void allocate(GLsizei width, GLsizei height);
+
+    SP_ShaderProgram program;
+    GLuint texture;
+    GLsizei levelWidth;
+    GLsizei levelHeight;
+    GLint levels;
+};
+
+#endif //BEZIER_HIZ_PYRAMID_HPP
@@ -0,0 +1,135 @@
+#include "IndirectPatchDraws.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    constexpr GLuint WORKGROUP_SIZE = 64;
+
+    // DrawArraysIndirectCommand
+    constexpr GLuint COMMAND_SIZE = 4 * sizeof(GLuint);
+
+    bool computeShadersSupported() {
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        return (major > 4 || (major == 4 && minor >= 3)) && glDispatchCompute;
+    }
+}
+
+IndirectPatchDraws::IndirectPatchDraws() :
+        patchCount(0),
+        commandCapacity(0),
+        tableRevision(0) {
+}
+
+void IndirectPatchDraws::release() {
+    program.reset();
+    table.reset();
+    commands.reset();
+    ranges.clear();
+    patchCount = 0;
+    commandCapacity = 0;
+    tableRevision = 0;
+}
+
+bool IndirectPatchDraws::init(ShaderLibrary& library) {
+    if (!computeShadersSupported()) {
+        std::cerr << "No compute shaders, patch draws are issued by the CPU"
+                  << std::endl;
+        return false;
+    }
+
+    program = library.create({
+        {GL_COMPUTE_SHADER, "shaders/patch_commands_comp.glsl"}
+    }, "patch_commands");
+    if (!program) {
+        return false;
+    }
+
+    table = VBO::create(2);
+    commands = VBO::create(4);
+    ranges.clear();
+    patchCount = 0;
+    commandCapacity = 0;
+    // forces the first upload
+    tableRevision = ~std::uint64_t(0);
+    return true;
+}
+
+void IndirectPatchDraws::uploadTable(const PatchBatches& batches) {
+    std::vector<GLuint> entries;
+    ranges.clear();
+    for (const auto& batch : batches.batches()) {
+        ranges.emplace_back(static_cast<GLuint>(entries.size() / 2), batch.size());
+        for (GLsizei i = 0; i < batch.size(); ++i) {
+            entries.push_back(static_cast<GLuint>(batch.firsts[i]));
+            entries.push_back(static_cast<GLuint>(batch.counts[i]));
+        }
+    }
+    patchCount = static_cast<GLuint>(entries.size() / 2);
+    table->init(entries);
+
+    if (patchCount > commandCapacity) {
+        // grows geometrically, streamed imports append a little each frame
+        commandCapacity = std::max(patchCount, 2 * commandCapacity);
+        commands->allocate(commandCapacity);
+    }
+    tableRevision = batches.revision();
+}
+
+void IndirectPatchDraws::generate(const PatchPool& pool,
+                                  const PatchBatches& batches,
+                                  const GLMat4& mvp,
+                                  const HiZPyramid* occluders,
+                                  const GLMat4& occludersMvp) {
+    if (!available()) {
+        return;
+    }
+    if (batches.revision() != tableRevision) {
+        uploadTable(batches);
+    }
+    if (patchCount == 0) {
+        return;
+    }
+
+    program->bind();
+    set_uniform_value("uMvpMatrix", mvp);
+    set_uniform_value("uPatchCount", patchCount);
+    set_uniform_value("uCPStride",
+                      static_cast<GLuint>(ControlPointFormat::stride / sizeof(GLfloat)));
+
+    const bool occlusion = occluders && !occluders->empty();
+    set_uniform_value("uOcclusionCulling", occlusion);
+    if (occlusion) {
+        set_uniform_value("uHiZ", static_cast<int32_t>(occluders->bind(0)));
+        set_uniform_value("uHiZLevels", static_cast<int32_t>(occluders->levelCount()));
+        set_uniform_value("uHiZMvpMatrix", occludersMvp);
+    }
+
+    table->bind_compute(0);
+    pool.controlPoints().getVbo()->bind_compute(1);
+    commands->bind_compute(2);
+
+    glDispatchCompute((patchCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+    for (GLuint binding = 0; binding < 3; ++binding) {
+        VBO::unbind_compute(binding);
+    }
+    Texture2D::unbind();
+    ShaderProgram::unbind();
+}
+
+void IndirectPatchDraws::draw(std::size_t index) const {
+    if (index >= ranges.size() || ranges[index].second == 0) {
+        return;
+    }
+    const auto offset = static_cast<std::uintptr_t>(ranges[index].first) * COMMAND_SIZE;
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->id());
+    glMultiDrawArraysIndirect(GL_PATCHES, reinterpret_cast<const void*>(offset),
+                              ranges[index].second, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
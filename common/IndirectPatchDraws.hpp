@@ -0,0 +1,66 @@
+#ifndef BEZIER_INDIRECT_PATCH_DRAWS_HPP
+#define BEZIER_INDIRECT_PATCH_DRAWS_HPP
+
+#include "HiZPyramid.hpp"
+#include "PatchBatches.hpp"
+#include "ShaderLibrary.hpp"
+
+#include "easycppogl_src/vbo.h"
+
+/**
+ * Draw commands of the patches generated on the GPU.
+ *
+ * A compute pass reads the patch table (the batches concatenated) and the
+ * control points, culls each patch against the view frustum and writes its
+ * DrawArraysIndirectCommand, an empty one when culled. Each batch is then
+ * drawn by one glMultiDrawArraysIndirect, so the CPU cost of a frame does
+ * not depend on the number of patches. Given a depth pyramid of the
+ * previous frame, the patches it hides are culled too.
+ *
+ * Needs compute shaders (OpenGL 4.3), see available.
+ */
+class IndirectPatchDraws {
+public:
+    IndirectPatchDraws();
+
+    /**
+     * Build the compute program, returns available().
+     */
+    bool init(ShaderLibrary& library);
+
+    inline bool available() const { return static_cast<bool>(program); }
+
+    /**
+     * Write the commands of every patch of batches, pool holding their
+     * control points, seen through mvp. Patches hidden in occluders (if not
+     * null nor empty), a depth pyramid seen through occludersMvp, are culled.
+     */
+    void generate(const PatchPool& pool, const PatchBatches& batches,
+                  const GLMat4& mvp, const HiZPyramid* occluders = nullptr,
+                  const GLMat4& occludersMvp = GLMat4::Identity());
+
+    /**
+     * Draw batch index of the last generate, with the program and VAO bound.
+     */
+    void draw(std::size_t index) const;
+
+    /**
+     * Delete the program and the buffers, while the context still exists.
+     */
+    void release();
+
+private:
+    void uploadTable(const PatchBatches& batches);
+
+    SP_ShaderProgram program;
+    SP_VBO table;
+    SP_VBO commands;
+
+    // first command and command count of each batch
+    std::vector<std::pair<GLuint, GLsizei>> ranges;
+    GLuint patchCount;
+    GLuint commandCapacity;
+    std::uint64_t tableRevision;
+};
+
+#endif //BEZIER_INDIRECT_PATCH_DRAWS_HPP
@@ -0,0 +1,686 @@
+#include "MeshExporter.hpp"
+
+#include "Bezier.hpp"
+#include "Parallel.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using HPoints = std::vector<Homogeneous<float>,
+                            Eigen::aligned_allocator<Homogeneous<float>>>;
+using Points = std::vector<Point3<float>>;
+
+constexpr std::size_t PATCHES_PER_JOB = 64;
+
+/**
+ * File preallocated to its final size and written at explicit offsets,
+ * from any number of threads.
+ */
+class OutputFile {
+public:
+    OutputFile() :
+#ifdef _WIN32
+            handle(INVALID_HANDLE_VALUE) {
+#else
+            fd(-1) {
+#endif
+    }
+
+    ~OutputFile() {
+        close();
+    }
+
+#ifdef _WIN32
+    bool open(const std::string& path, std::uint64_t size) {
+        handle = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr,
+                             CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        return SetFilePointerEx(handle, end, nullptr, FILE_BEGIN)
+               && SetEndOfFile(handle);
+    }
+
+    bool writeAt(std::uint64_t offset, const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            const DWORD request = static_cast<DWORD>(
+                    std::min<std::size_t>(size, 1u << 30)
+            );
+            DWORD written = 0;
+            if (!WriteFile(handle, bytes, request, &written, &position)
+                || written == 0) {
+                return false;
+            }
+            bytes += written;
+            offset += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool close() {
+        const bool ok = handle == INVALID_HANDLE_VALUE || CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+        return ok;
+    }
+
+private:
+    HANDLE handle;
+#else
+    bool open(const std::string& path, std::uint64_t size) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+#ifdef __linux__
+        // reserve the blocks now, the workers then never extend the file
+        if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+            return true;
+        }
+#endif
+        return ftruncate(fd, static_cast<off_t>(size)) == 0;
+    }
+
+    bool writeAt(std::uint64_t offset, const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t written = pwrite(fd, bytes, size,
+                                           static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            bytes += written;
+            offset += static_cast<std::uint64_t>(written);
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    bool close() {
+        const bool ok = fd < 0 || ::close(fd) == 0;
+        fd = -1;
+        return ok;
+    }
+
+private:
+    int fd;
+#endif
+};
+
+/**
+ * (level + 1)^2 vertices of a tessellated patch, vertex (i, j) being at
+ * j * side + i. The 4 * level boundary vertices are numbered in grid order,
+ * the interior ones too.
+ */
+struct GridLayout {
+    explicit GridLayout(GLuint level) :
+            level(level),
+            side(level + 1),
+            vertices(side * side),
+            boundary(4 * level),
+            interior((level - 1) * (level - 1)),
+            triangles(2 * level * level),
+            boundaryIndex(vertices, -1),
+            interiorIndex(vertices, -1) {
+        int b = 0;
+        int n = 0;
+        for (std::size_t j = 0; j < side; ++j) {
+            for (std::size_t i = 0; i < side; ++i) {
+                const std::size_t g = j * side + i;
+                if (i == 0 || j == 0 || i == level || j == level) {
+                    boundaryIndex[g] = b++;
+                    boundaryVertices.push_back(static_cast<GLuint>(g));
+                } else {
+                    interiorIndex[g] = n++;
+                }
+            }
+        }
+    }
+
+    /**
+     * Grid vertices of the two triangles of each quad, counter clockwise
+     * in (u, v).
+     */
+    template <typename Fn>
+    void forEachTriangle(const Fn& fn) const {
+        for (std::size_t j = 0; j < level; ++j) {
+            for (std::size_t i = 0; i < level; ++i) {
+                const std::size_t a = j * side + i;
+                fn(a, a + 1, a + side + 1);
+                fn(a, a + side + 1, a + side);
+            }
+        }
+    }
+
+    std::size_t level;
+    std::size_t side;
+    std::size_t vertices;
+    std::size_t boundary;
+    std::size_t interior;
+    std::size_t triangles;
+    std::vector<int> boundaryIndex;
+    std::vector<int> interiorIndex;
+    std::vector<GLuint> boundaryVertices;
+};
+
+/**
+ * Per worker buffers.
+ */
+struct Scratch {
+    HPoints controlPoints;
+    Points grid;
+    std::vector<char> vertexBytes;
+    std::vector<char> triangleBytes;
+};
+
+void tessellate(const std::vector<ControlPoint>& points, const PatchRecord& patch,
+                const GridLayout& layout, Scratch& scratch) {
+    scratch.controlPoints.resize(patch.count());
+    for (GLuint i = 0; i < patch.count(); ++i) {
+        scratch.controlPoints[i] = points[patch.first + i].homogeneous();
+    }
+    scratch.grid.resize(layout.vertices);
+    samplePatch(scratch.controlPoints.data(), patch.countU, patch.countV,
+                layout.side, layout.side, scratch.grid.data());
+}
+
+struct VertexKey {
+    std::int64_t x;
+    std::int64_t y;
+    std::int64_t z;
+
+    inline bool operator==(const VertexKey& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct VertexKeyHash {
+    inline std::size_t operator()(const VertexKey& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(key.x) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<std::uint64_t>(key.y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= static_cast<std::uint64_t>(key.z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+};
+
+/**
+ * Boundary vertices closer than a millionth of the scene size share a key.
+ * Each key is handled by one shard, the shards being welded in parallel;
+ * a vertex is owned by its smallest reference so the result does not
+ * depend on the scheduling.
+ */
+void weldBoundaries(const std::vector<ControlPoint>& points,
+                    const std::vector<PatchRecord>& patches,
+                    const GridLayout& layout, unsigned threads,
+                    std::vector<Scratch>& scratch,
+                    std::vector<std::uint64_t>& owner) {
+    GLVec3 lower = GLVec3::Constant(std::numeric_limits<float>::max());
+    GLVec3 upper = -lower;
+    for (const auto& cp : points) {
+        lower = lower.cwiseMin(cp.position);
+        upper = upper.cwiseMax(cp.position);
+    }
+    const double extent = (upper - lower).cast<double>().maxCoeff();
+    const double cell = extent > 0. ? extent * 1e-6 : 1e-6;
+
+    struct Entry {
+        VertexKey key;
+        std::uint64_t ref;
+    };
+    const std::size_t shardCount = std::size_t(threads) * 4;
+    std::vector<std::vector<std::vector<Entry>>> buckets(
+            threads, std::vector<std::vector<Entry>>(shardCount)
+    );
+    const VertexKeyHash hash;
+
+    parallelFor(patches.size(), PATCHES_PER_JOB, threads,
+                [&](std::size_t begin, std::size_t end, unsigned worker) {
+                    auto& local = scratch[worker];
+                    for (std::size_t p = begin; p < end; ++p) {
+                        tessellate(points, patches[p], layout, local);
+                        for (std::size_t b = 0; b < layout.boundary; ++b) {
+                            const auto& v = local.grid[layout.boundaryVertices[b]];
+                            const VertexKey key{
+                                    std::llround((v.x() - lower.x()) / cell),
+                                    std::llround((v.y() - lower.y()) / cell),
+                                    std::llround((v.z() - lower.z()) / cell)
+                            };
+                            buckets[worker][hash(key) % shardCount].push_back(
+                                    {key, p * layout.boundary + b}
+                            );
+                        }
+                    }
+                });
+
+    parallelFor(shardCount, 1, threads,
+                [&](std::size_t shard, std::size_t, unsigned) {
+                    std::size_t size = 0;
+                    for (const auto& bucket : buckets) {
+                        size += bucket[shard].size();
+                    }
+                    std::unordered_map<VertexKey, std::uint64_t, VertexKeyHash> first;
+                    first.reserve(size);
+                    for (const auto& bucket : buckets) {
+                        for (const auto& entry : bucket[shard]) {
+                            auto it = first.emplace(entry.key, entry.ref).first;
+                            it->second = std::min(it->second, entry.ref);
+                        }
+                    }
+                    for (const auto& bucket : buckets) {
+                        for (const auto& entry : bucket[shard]) {
+                            owner[entry.ref] = first[entry.key];
+                        }
+                    }
+                });
+}
+
+/**
+ * Output numbering of the tessellated vertices. Patch p writes its own
+ * boundary vertices (in boundary order) then its interior ones from
+ * firstVertex[p].
+ */
+struct VertexNumbering {
+    const GridLayout& layout;
+    std::vector<std::uint64_t> owner;
+    std::vector<std::uint64_t> firstVertex;
+    std::vector<std::uint32_t> boundaryIds;
+
+    inline bool ownsBoundary(std::size_t p, std::size_t b) const {
+        const std::uint64_t ref = p * layout.boundary + b;
+        return owner[ref] == ref;
+    }
+
+    inline std::uint64_t ownedBoundaryCount(std::size_t p) const {
+        return firstVertex[p + 1] - firstVertex[p] - layout.interior;
+    }
+
+    inline std::uint32_t id(std::size_t p, std::size_t g) const {
+        const int b = layout.boundaryIndex[g];
+        if (b >= 0) {
+            return boundaryIds[owner[p * layout.boundary + b]];
+        }
+        return static_cast<std::uint32_t>(
+                firstVertex[p] + ownedBoundaryCount(p) + layout.interiorIndex[g]
+        );
+    }
+
+    inline std::uint64_t total() const { return firstVertex.back(); }
+};
+
+/**
+ * Call fn(grid index) on the vertices written by patch p, in output order.
+ */
+template <typename Fn>
+void forEachWrittenVertex(const VertexNumbering& numbering, std::size_t p,
+                          const Fn& fn) {
+    const auto& layout = numbering.layout;
+    for (std::size_t b = 0; b < layout.boundary; ++b) {
+        if (numbering.ownsBoundary(p, b)) {
+            fn(layout.boundaryVertices[b]);
+        }
+    }
+    for (std::size_t g = 0; g < layout.vertices; ++g) {
+        if (layout.interiorIndex[g] >= 0) {
+            fn(g);
+        }
+    }
+}
+
+template <typename T>
+inline void append(std::vector<char>& bytes, const T& value) {
+    const auto* raw = reinterpret_cast<const char*>(&value);
+    bytes.insert(bytes.end(), raw, raw + sizeof(T));
+}
+
+std::size_t decimalDigits(std::uint64_t value) {
+    std::size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * Fixed width "%+13.6e" of a float, without the locale and format string
+ * handling of printf which dominates the OBJ export otherwise.
+ */
+void formatScientific(float value, char* out) {
+    constexpr std::size_t width = 13;
+    if (!std::isfinite(value)) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%+13.6e", double(value));
+        std::memcpy(out, text, width);
+        return;
+    }
+
+    double a = std::fabs(double(value));
+    int exponent = 0;
+    std::uint64_t digits = 0;
+    if (a > 0.) {
+        exponent = static_cast<int>(std::floor(std::log10(a)));
+        digits = static_cast<std::uint64_t>(std::nearbyint(a * std::pow(10., 6 - exponent)));
+        if (digits >= 10000000) {
+            digits /= 10;
+            ++exponent;
+        } else if (digits < 1000000) {
+            digits = static_cast<std::uint64_t>(std::nearbyint(a * std::pow(10., 7 - exponent)));
+            --exponent;
+        }
+    }
+
+    out[0] = std::signbit(value) ? '-' : '+';
+    for (int i = 8; i >= 3; --i) {
+        out[i] = char('0' + digits % 10);
+        digits /= 10;
+    }
+    out[2] = '.';
+    out[1] = char('0' + digits);
+    out[9] = 'e';
+    out[10] = exponent < 0 ? '-' : '+';
+    const int e = std::abs(exponent);
+    out[11] = char('0' + e / 10);
+    out[12] = char('0' + e % 10);
+}
+
+/**
+ * value right aligned on width characters.
+ */
+void formatUnsigned(std::uint64_t value, std::size_t width, char* out) {
+    std::size_t i = width;
+    do {
+        out[--i] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0 && i > 0);
+    while (i > 0) {
+        out[--i] = ' ';
+    }
+}
+
+bool littleEndian() {
+    const std::uint16_t probe = 1;
+    return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+
+/**
+ * Byte layout of the output file: header, the vertices of every patch
+ * (none for STL) then their triangles. All the records of a region have the
+ * same size, so the offset of a patch block only depends on its first
+ * vertex and triangle.
+ */
+struct FileLayout {
+    MeshFormat format;
+    std::string header;
+    std::size_t vertexSize;
+    std::size_t triangleSize;
+    std::size_t indexWidth;
+    std::uint64_t verticesOffset;
+    std::uint64_t trianglesOffset;
+    std::uint64_t size;
+
+    FileLayout(MeshFormat format, std::uint64_t vertexCount,
+               std::uint64_t triangleCount) :
+            format(format),
+            vertexSize(0),
+            triangleSize(0),
+            indexWidth(decimalDigits(vertexCount)) {
+        switch (format) {
+            case MeshFormat::Stl: {
+                header.assign(80, ' ');
+                const char title[] = "binary STL, tessellated Bezier patches";
+                std::memcpy(&header[0], title, sizeof(title) - 1);
+                const auto count = static_cast<std::uint32_t>(triangleCount);
+                header.append(reinterpret_cast<const char*>(&count), sizeof(count));
+                vertexSize = 0;
+                triangleSize = 50;
+                break;
+            }
+            case MeshFormat::Ply:
+                header = std::string("ply\nformat ")
+                         + (littleEndian() ? "binary_little_endian" : "binary_big_endian")
+                         + " 1.0\ncomment tessellated Bezier patches\n"
+                         + "element vertex " + std::to_string(vertexCount) + "\n"
+                         + "property float x\nproperty float y\nproperty float z\n"
+                         + "element face " + std::to_string(triangleCount) + "\n"
+                         + "property list uchar uint vertex_indices\nend_header\n";
+                vertexSize = 3 * sizeof(float);
+                triangleSize = 1 + 3 * sizeof(std::uint32_t);
+                break;
+            case MeshFormat::Obj:
+                header = "# tessellated Bezier patches\n";
+                // "v" and 3 x " %+13.6e", "f" and 3 x " %<width>u"
+                vertexSize = 1 + 3 * 14 + 1;
+                triangleSize = 1 + 3 * (1 + indexWidth) + 1;
+                break;
+        }
+        verticesOffset = header.size();
+        trianglesOffset = verticesOffset + vertexCount * vertexSize;
+        size = trianglesOffset + triangleCount * triangleSize;
+    }
+
+    void appendVertex(std::vector<char>& bytes, const Point3<float>& v) const {
+        if (format == MeshFormat::Ply) {
+            append(bytes, v.x());
+            append(bytes, v.y());
+            append(bytes, v.z());
+        } else if (format == MeshFormat::Obj) {
+            const std::size_t start = bytes.size();
+            bytes.resize(start + vertexSize);
+            char* text = bytes.data() + start;
+            text[0] = 'v';
+            for (int c = 0; c < 3; ++c) {
+                text[1 + 14 * c] = ' ';
+                formatScientific(v[c], text + 2 + 14 * c);
+            }
+            text[vertexSize - 1] = '\n';
+        }
+    }
+
+    void appendTriangle(std::vector<char>& bytes, const Point3<float>* v,
+                        const std::uint32_t* ids) const {
+        if (format == MeshFormat::Stl) {
+            Point3<float> normal = (v[1] - v[0]).cross(v[2] - v[0]);
+            const float length = normal.norm();
+            if (length > 0.f) {
+                normal /= length;
+            }
+            for (int c = 0; c < 3; ++c) {
+                append(bytes, normal[c]);
+            }
+            for (int i = 0; i < 3; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    append(bytes, v[i][c]);
+                }
+            }
+            append(bytes, std::uint16_t(0));
+        } else if (format == MeshFormat::Ply) {
+            append(bytes, std::uint8_t(3));
+            for (int i = 0; i < 3; ++i) {
+                append(bytes, ids[i]);
+            }
+        } else {
+            const std::size_t start = bytes.size();
+            bytes.resize(start + triangleSize);
+            char* text = bytes.data() + start;
+            text[0] = 'f';
+            for (int i = 0; i < 3; ++i) {
+                text[1 + (1 + indexWidth) * i] = ' ';
+                formatUnsigned(std::uint64_t(ids[i]) + 1, indexWidth,
+                               text + 2 + (1 + indexWidth) * i);
+            }
+            text[triangleSize - 1] = '\n';
+        }
+    }
+};
+
+} // namespace
+
+
+bool meshFormatFromPath(const std::string& path, MeshFormat& format) {
+    if (hasExtension(path, "stl")) {
+        format = MeshFormat::Stl;
+    } else if (hasExtension(path, "ply")) {
+        format = MeshFormat::Ply;
+    } else if (hasExtension(path, "obj")) {
+        format = MeshFormat::Obj;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool exportMesh(const std::string& path, const PatchPool& pool,
+                const MeshExportOptions& options) {
+    MeshFormat format;
+    if (!meshFormatFromPath(path, format)) {
+        std::cerr << "Unknown mesh format '" << path << "'" << std::endl;
+        return false;
+    }
+    if (!pool.isResident()) {
+        std::cerr << "Control net is not resident in memory, cannot export it"
+                  << std::endl;
+        return false;
+    }
+    if (options.level < 1) {
+        std::cerr << "Invalid tessellation level" << std::endl;
+        return false;
+    }
+
+    const auto& points = pool.controlPoints().points();
+    std::vector<PatchRecord> patches;
+    for (const auto& patch : pool.patches()) {
+        if (!patch.isCurve() && patch.countU <= BEZIER_MAX_CP
+            && patch.countV <= BEZIER_MAX_CP) {
+            patches.push_back(patch);
+        }
+    }
+    if (patches.empty()) {
+        std::cerr << "No patch to export" << std::endl;
+        return false;
+    }
+
+    const GridLayout layout(options.level);
+    const std::size_t patchCount = patches.size();
+    const unsigned threads = workerCount(options.threads, patchCount);
+    std::vector<Scratch> scratch(threads);
+
+    VertexNumbering numbering{layout, std::vector<std::uint64_t>(patchCount * layout.boundary),
+                              std::vector<std::uint64_t>(patchCount + 1),
+                              std::vector<std::uint32_t>(patchCount * layout.boundary)};
+    std::iota(numbering.owner.begin(), numbering.owner.end(), std::uint64_t(0));
+    if (options.weld && format != MeshFormat::Stl) {
+        weldBoundaries(points, patches, layout, threads, scratch, numbering.owner);
+    }
+
+    // prefix sum of the vertices written by each patch
+    parallelFor(patchCount, PATCHES_PER_JOB, threads,
+                [&](std::size_t begin, std::size_t end, unsigned) {
+                    for (std::size_t p = begin; p < end; ++p) {
+                        std::uint64_t count = layout.interior;
+                        for (std::size_t b = 0; b < layout.boundary; ++b) {
+                            count += numbering.ownsBoundary(p, b) ? 1 : 0;
+                        }
+                        numbering.firstVertex[p + 1] = count;
+                    }
+                });
+    std::partial_sum(numbering.firstVertex.begin(), numbering.firstVertex.end(),
+                     numbering.firstVertex.begin());
+
+    const std::uint64_t triangleCount = patchCount * layout.triangles;
+    if (numbering.total() > std::numeric_limits<std::uint32_t>::max()
+        || triangleCount > std::numeric_limits<std::uint32_t>::max()) {
+        std::cerr << "Mesh too large for 32 bit indices" << std::endl;
+        return false;
+    }
+
+    parallelFor(patchCount, PATCHES_PER_JOB, threads,
+                [&](std::size_t begin, std::size_t end, unsigned) {
+                    for (std::size_t p = begin; p < end; ++p) {
+                        auto id = static_cast<std::uint32_t>(numbering.firstVertex[p]);
+                        for (std::size_t b = 0; b < layout.boundary; ++b) {
+                            if (numbering.ownsBoundary(p, b)) {
+                                numbering.boundaryIds[p * layout.boundary + b] = id++;
+                            }
+                        }
+                    }
+                });
+
+    const FileLayout file(format, numbering.total(), triangleCount);
+    OutputFile output;
+    if (!output.open(path, file.size)
+        || !output.writeAt(0, file.header.data(), file.header.size())) {
+        std::cerr << "Unable to write file '" << path << "'" << std::endl;
+        return false;
+    }
+
+    std::atomic<bool> failed(false);
+    parallelFor(patchCount, PATCHES_PER_JOB, threads,
+                [&](std::size_t begin, std::size_t end, unsigned worker) {
+                    auto& local = scratch[worker];
+                    auto& vertexBytes = local.vertexBytes;
+                    auto& faceBytes = local.triangleBytes;
+                    vertexBytes.clear();
+                    faceBytes.clear();
+
+                    for (std::size_t p = begin; p < end; ++p) {
+                        tessellate(points, patches[p], layout, local);
+                        const auto& grid = local.grid;
+                        forEachWrittenVertex(numbering, p, [&](std::size_t g) {
+                            file.appendVertex(vertexBytes, grid[g]);
+                        });
+                        layout.forEachTriangle([&](std::size_t a, std::size_t b,
+                                                   std::size_t c) {
+                            const Point3<float> v[3] = {grid[a], grid[b], grid[c]};
+                            const std::uint32_t ids[3] = {
+                                    numbering.id(p, a), numbering.id(p, b),
+                                    numbering.id(p, c)
+                            };
+                            file.appendTriangle(faceBytes, v, ids);
+                        });
+                    }
+
+                    const bool ok = output.writeAt(
+                            file.verticesOffset + numbering.firstVertex[begin] * file.vertexSize,
+                            vertexBytes.data(), vertexBytes.size()
+                    ) && output.writeAt(
+                            file.trianglesOffset + begin * layout.triangles * file.triangleSize,
+                            faceBytes.data(), faceBytes.size()
+                    );
+                    if (!ok) {
+                        failed = true;
+                    }
+                });
+
+    if (!output.close() || failed) {
+        std::cerr << "Error while writing file '" << path << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef BEZIER_MESH_EXPORTER_HPP
+#define BEZIER_MESH_EXPORTER_HPP
+
+#include "PatchPool.hpp"
+
+#include <string>
+
+enum class MeshFormat {
+    Stl,    // binary
+    Ply,    // binary, native endianness
+    Obj
+};
+
+struct MeshExportOptions {
+    // segments per patch edge, like the uLevel of the surface shaders
+    GLuint level = 16;
+    // merge the vertices shared by neighbouring patches (not for STL)
+    bool weld = true;
+    // 0: hardware concurrency
+    unsigned threads = 0;
+};
+
+/**
+ * Format matching the extension of path (.stl, .ply, .obj).
+ */
+bool meshFormatFromPath(const std::string& path, MeshFormat& format);
+
+/**
+ * Tessellate every rectangular patch of pool on a level x level grid and
+ * write the triangles in the format matching the extension of path.
+ *
+ * Patches are evaluated in parallel. The size of each patch block is known
+ * in advance, so a prefix sum gives its offset in the preallocated file and
+ * every worker writes its blocks in place. Welding keys the boundary
+ * vertices on their quantized position; each vertex is written by the
+ * first patch using it.
+ */
+bool exportMesh(const std::string& path, const PatchPool& pool,
+                const MeshExportOptions& options = MeshExportOptions());
+
+#endif //BEZIER_MESH_EXPORTER_HPP
@@ -0,0 +1,698 @@
+#include "NetImporter.hpp"
+
+#include "Bezier.hpp"
+#include "TextReader.hpp"
+#include "utils.hpp"
+
+#include <Eigen/LU>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+using HPoint = Homogeneous<double>;
+using HPoints = std::vector<HPoint, Eigen::aligned_allocator<HPoint>>;
+using Matrix = Eigen::MatrixXd;
+
+inline bool cancelled(const std::atomic<bool>* cancel) {
+    return cancel != nullptr && cancel->load(std::memory_order_relaxed);
+}
+
+double binomial(GLuint n, GLuint k) {
+    double result = 1.;
+    for (GLuint i = 1; i <= k; ++i) {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+/**
+ * Power basis coefficients of the Bernstein polynomials, same convention as
+ * the OBJ bmat: m(i, j) is the factor of t^j for the control point i.
+ */
+Matrix bernsteinBasis(GLuint degree) {
+    Matrix m = Matrix::Zero(degree + 1, degree + 1);
+    for (GLuint i = 0; i <= degree; ++i) {
+        for (GLuint j = i; j <= degree; ++j) {
+            const double sign = (j - i) % 2 == 0 ? 1. : -1.;
+            m(i, j) = sign * binomial(degree, i) * binomial(degree - i, j - i);
+        }
+    }
+    return m;
+}
+
+/**
+ * Matrix T turning the control points P of a basis matrix segment into
+ * Bezier points Q = T P: both give the same power coefficients when
+ * Mb^t Q = B^t P.
+ */
+Matrix bezierTransform(const std::vector<double>& bmat, GLuint degree) {
+    const Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                                         Eigen::RowMajor>>
+            basis(bmat.data(), degree + 1, degree + 1);
+    return bernsteinBasis(degree).transpose().partialPivLu()
+                                 .solve(basis.transpose());
+}
+
+/**
+ * Bezier segments of count points along one direction: segment s starts at
+ * s * step and has degree + 1 points, transform (if any) maps them to
+ * Bezier points.
+ */
+struct SegmentBasis {
+    GLuint degree;
+    GLuint step;
+    bool identity;
+    Matrix transform;
+
+    inline GLuint segments(std::size_t count) const {
+        if (count < degree + 1 || (count - degree - 1) % step != 0) {
+            return 0;
+        }
+        return static_cast<GLuint>((count - degree - 1) / step + 1);
+    }
+
+    inline double factor(GLuint row, GLuint column) const {
+        return identity ? (row == column ? 1. : 0.) : transform(row, column);
+    }
+};
+
+ControlPoint toControlPoint(const HPoint& p) {
+    return ControlPoint(fromHomogeneous(p).cast<float>(), float(p.w()));
+}
+
+/**
+ * Emit every patch of a countU x countV net of homogeneous points (stored
+ * iu * countV + iv), for curves countV == 1 and v is ignored.
+ */
+void emitSegments(const HPoints& net, std::size_t countU,
+                  std::size_t countV, const SegmentBasis& u,
+                  const SegmentBasis* v, const BezierSink& sink) {
+    const GLuint segU = u.segments(countU);
+    const GLuint segV = v != nullptr ? v->segments(countV) : 1;
+    const GLuint nu = u.degree + 1;
+    const GLuint nv = v != nullptr ? v->degree + 1 : 1;
+
+    std::vector<ControlPoint> patch(nu * nv);
+    for (GLuint su = 0; su < segU; ++su) {
+        for (GLuint sv = 0; sv < segV; ++sv) {
+            const std::size_t firstU = su * u.step;
+            const std::size_t firstV = v != nullptr ? sv * v->step : 0;
+            for (GLuint a = 0; a < nu; ++a) {
+                for (GLuint b = 0; b < nv; ++b) {
+                    HPoint q = HPoint::Zero();
+                    for (GLuint i = 0; i < nu; ++i) {
+                        const double fu = u.factor(a, i);
+                        if (fu == 0.) {
+                            continue;
+                        }
+                        for (GLuint j = 0; j < nv; ++j) {
+                            const double f = fu * (v != nullptr ? v->factor(b, j) : 1.);
+                            if (f != 0.) {
+                                q += f * net[(firstU + i) * countV + firstV + j];
+                            }
+                        }
+                    }
+                    patch[a * nv + b] = toControlPoint(q);
+                }
+            }
+            sink(patch.data(), nu, nv);
+        }
+    }
+}
+
+
+enum class ObjBasis {
+    Bezier,
+    BMatrix,
+    BSpline,
+    Unsupported
+};
+
+/**
+ * State of the free-form statements of an OBJ file. cstype, deg, bmat and
+ * step apply to every following element, curv/surf start an element that
+ * parm statements complete until end.
+ */
+class ObjParser {
+public:
+    explicit ObjParser(const BezierSink& sink) :
+            sink(sink),
+            basis(ObjBasis::Bezier),
+            rational(false),
+            degree{1, 1},
+            step{0, 0},
+            inElement(false),
+            surface(false),
+            line(0),
+            skipped(0) {
+    }
+
+    bool parse(ChunkedLineReader& reader, const std::atomic<bool>* cancel) {
+        TextSpan text;
+        while (!cancelled(cancel) && reader.nextLine(text)) {
+            ++line;
+            TextSpan keyword;
+            if (!nextToken(text, keyword) || *keyword.begin == '#') {
+                continue;
+            }
+            statement(keyword, text);
+        }
+        finishElement();
+
+        if (skipped > 0) {
+            std::cerr << "OBJ: " << skipped << " element(s) skipped" << std::endl;
+        }
+        return true;
+    }
+
+private:
+    void statement(const TextSpan& keyword, TextSpan& args) {
+        if (keyword == "v") {
+            vertex(args);
+        } else if (keyword == "cstype") {
+            cstype(args);
+        } else if (keyword == "deg") {
+            readUnsigned(args, degree, 2);
+        } else if (keyword == "step") {
+            readUnsigned(args, step, 2);
+        } else if (keyword == "bmat") {
+            readDirection(args, bmat);
+        } else if (keyword == "curv" || keyword == "surf") {
+            finishElement();
+            startElement(keyword == "surf", args);
+        } else if (keyword == "parm") {
+            readDirection(args, parm);
+        } else if (keyword == "end") {
+            finishElement();
+        }
+    }
+
+    void vertex(TextSpan& args) {
+        double values[4] = {0., 0., 0., 1.};
+        TextSpan token;
+        for (double& value : values) {
+            if (!nextToken(args, token)) {
+                break;
+            }
+            if (!parseDouble(token, value)) {
+                warning("invalid vertex");
+                break;
+            }
+        }
+        vertices.push_back(toHomogeneous<double>(
+                {values[0], values[1], values[2]}, values[3]
+        ));
+    }
+
+    void cstype(TextSpan& args) {
+        TextSpan token{args.end, args.end};
+        rational = false;
+        if (nextToken(args, token) && token == "rat") {
+            rational = true;
+            nextToken(args, token);
+        }
+        if (token == "bezier") {
+            basis = ObjBasis::Bezier;
+        } else if (token == "bmatrix") {
+            basis = ObjBasis::BMatrix;
+        } else if (token == "bspline") {
+            basis = ObjBasis::BSpline;
+        } else {
+            basis = ObjBasis::Unsupported;
+        }
+    }
+
+    void readUnsigned(TextSpan& args, GLuint* values, std::size_t count) {
+        TextSpan token;
+        long value;
+        for (std::size_t i = 0; i < count && nextToken(args, token); ++i) {
+            if (parseLong(token, value) && value >= 0) {
+                values[i] = static_cast<GLuint>(value);
+            }
+        }
+    }
+
+    /**
+     * "u|v values..." statements (bmat, parm).
+     */
+    void readDirection(TextSpan& args, std::vector<double>* values) {
+        TextSpan token;
+        if (!nextToken(args, token) || (token != "u" && token != "v")) {
+            warning("expected u or v");
+            return;
+        }
+        auto& out = values[token == "u" ? 0 : 1];
+        out.clear();
+        double value;
+        while (nextToken(args, token)) {
+            if (!parseDouble(token, value)) {
+                warning("invalid number");
+                return;
+            }
+            out.push_back(value);
+        }
+    }
+
+    void startElement(bool isSurface, TextSpan& args) {
+        inElement = true;
+        surface = isSurface;
+        indices.clear();
+        parm[0].clear();
+        parm[1].clear();
+
+        // parameter range: u0 u1 for curves, s0 s1 t0 t1 for surfaces
+        TextSpan token;
+        for (int i = 0; i < (surface ? 4 : 2); ++i) {
+            nextToken(args, token);
+        }
+
+        const auto count = static_cast<long>(vertices.size());
+        long index;
+        while (nextToken(args, token)) {
+            // v/vt/vn references: only the vertex matters
+            const char* slash = std::find(token.begin, token.end, '/');
+            if (!parseLong({token.begin, slash}, index)) {
+                warning("invalid vertex reference");
+                inElement = false;
+                return;
+            }
+            index = index < 0 ? count + index : index - 1;
+            if (index < 0 || index >= count) {
+                warning("vertex reference out of range");
+                inElement = false;
+                return;
+            }
+            indices.push_back(static_cast<std::size_t>(index));
+        }
+    }
+
+    void finishElement() {
+        if (!inElement) {
+            return;
+        }
+        inElement = false;
+
+        if (basis == ObjBasis::Unsupported) {
+            ++skipped;
+            return;
+        }
+        const bool ok = basis == ObjBasis::BSpline
+                        ? (surface ? bsplineSurface() : bsplineCurve())
+                        : (surface ? basisSurface() : basisCurve());
+        if (!ok) {
+            ++skipped;
+        }
+    }
+
+    ControlPoint controlPoint(std::size_t index) const {
+        const HPoint& p = vertices[index];
+        return rational ? toControlPoint(p)
+                        : ControlPoint(fromHomogeneous(p).cast<float>());
+    }
+
+    HPoint homogeneousPoint(std::size_t index) const {
+        const HPoint& p = vertices[index];
+        return rational ? p : toHomogeneous<double>(fromHomogeneous(p));
+    }
+
+    bool bsplineCurve() {
+        NurbsCurve curve;
+        curve.degree = degree[0];
+        curve.knots = parm[0];
+        curve.points.reserve(indices.size());
+        for (std::size_t index : indices) {
+            curve.points.push_back(controlPoint(index));
+        }
+        if (!decomposeToBezier(curve, sink)) {
+            return warning("invalid B-spline curve");
+        }
+        return true;
+    }
+
+    bool bsplineSurface() {
+        NurbsSurface net;
+        net.degreeU = degree[0];
+        net.degreeV = degree[1];
+        if (parm[0].size() < degree[0] + 2 || parm[1].size() < degree[1] + 2) {
+            return warning("missing knots");
+        }
+        net.countU = static_cast<GLuint>(parm[0].size() - degree[0] - 1);
+        net.countV = static_cast<GLuint>(parm[1].size() - degree[1] - 1);
+        net.knotsU = parm[0];
+        net.knotsV = parm[1];
+        if (indices.size() != std::size_t(net.countU) * net.countV) {
+            return warning("control point count does not match the knots");
+        }
+
+        // OBJ lists the points u first
+        net.points.resize(indices.size());
+        for (GLuint iv = 0; iv < net.countV; ++iv) {
+            for (GLuint iu = 0; iu < net.countU; ++iu) {
+                net.points[iu * net.countV + iv] =
+                        controlPoint(indices[iv * net.countU + iu]);
+            }
+        }
+        if (!decomposeToBezier(net, sink)) {
+            return warning("invalid B-spline surface");
+        }
+        return true;
+    }
+
+    bool segmentBasis(int direction, SegmentBasis& out) {
+        out.degree = degree[direction];
+        if (out.degree < 1 || out.degree + 1 > BEZIER_MAX_CP) {
+            return warning("invalid degree");
+        }
+        out.identity = basis == ObjBasis::Bezier;
+        out.step = out.identity ? out.degree : step[direction];
+        if (out.step < 1) {
+            return warning("missing step");
+        }
+        if (!out.identity) {
+            const std::size_t size = (out.degree + 1) * (out.degree + 1);
+            if (bmat[direction].size() != size) {
+                return warning("basis matrix does not match the degree");
+            }
+            out.transform = bezierTransform(bmat[direction], out.degree);
+        }
+        return true;
+    }
+
+    bool basisCurve() {
+        SegmentBasis u;
+        if (!segmentBasis(0, u)) {
+            return false;
+        }
+        if (u.segments(indices.size()) == 0) {
+            return warning("control point count does not match the degree");
+        }
+
+        HPoints net;
+        net.reserve(indices.size());
+        for (std::size_t index : indices) {
+            net.push_back(homogeneousPoint(index));
+        }
+        emitSegments(net, net.size(), 1, u, nullptr, sink);
+        return true;
+    }
+
+    bool basisSurface() {
+        SegmentBasis u, v;
+        if (!segmentBasis(0, u) || !segmentBasis(1, v)) {
+            return false;
+        }
+
+        // parm gives the global parameters of the segment ends, one
+        // segment per direction without it
+        const std::size_t segU = std::max<std::size_t>(parm[0].size(), 2) - 1;
+        const std::size_t segV = std::max<std::size_t>(parm[1].size(), 2) - 1;
+        const std::size_t countU = (segU - 1) * u.step + u.degree + 1;
+        const std::size_t countV = (segV - 1) * v.step + v.degree + 1;
+        if (indices.size() != countU * countV) {
+            return warning("control point count does not match the degrees");
+        }
+
+        HPoints net(indices.size());
+        for (std::size_t iv = 0; iv < countV; ++iv) {
+            for (std::size_t iu = 0; iu < countU; ++iu) {
+                net[iu * countV + iv] = homogeneousPoint(indices[iv * countU + iu]);
+            }
+        }
+        emitSegments(net, countU, countV, u, &v, sink);
+        return true;
+    }
+
+    bool warning(const char* message) const {
+        std::cerr << "OBJ line " << line << ": " << message << std::endl;
+        return false;
+    }
+
+    const BezierSink& sink;
+
+    HPoints vertices;
+
+    ObjBasis basis;
+    bool rational;
+    GLuint degree[2];
+    GLuint step[2];
+    std::vector<double> bmat[2];
+
+    bool inElement;
+    bool surface;
+    std::vector<std::size_t> indices;
+    std::vector<double> parm[2];
+
+    std::size_t line;
+    std::size_t skipped;
+};
+
+
+/**
+ * Parameter data of one IGES entity split on the parameter delimiter,
+ * empty fields read as 0.
+ */
+bool igesParameters(const std::string& record, char delimiter,
+                    std::vector<double>& values) {
+    values.clear();
+    const char* p = record.data();
+    const char* const end = p + record.size();
+    for (;;) {
+        const char* next = std::find(p, end, delimiter);
+        TextSpan field{p, next};
+        while (!field.empty() && *field.begin == ' ') {
+            ++field.begin;
+        }
+        while (!field.empty() && *(field.end - 1) == ' ') {
+            --field.end;
+        }
+        double value = 0.;
+        if (!field.empty() && !parseDouble(field, value)) {
+            return false;
+        }
+        values.push_back(value);
+        if (next == end) {
+            return true;
+        }
+        p = next + 1;
+    }
+}
+
+/**
+ * value as an index or count of at most max, false if it is not a finite
+ * non-negative integer in range.
+ */
+bool igesInteger(double value, std::uint64_t max, std::uint64_t& out) {
+    if (!std::isfinite(value) || value < 0. || value != std::floor(value)
+        || value > static_cast<double>(max)) {
+        return false;
+    }
+    out = static_cast<std::uint64_t>(value);
+    return true;
+}
+
+/**
+ * a * b, false on overflow.
+ */
+bool checkedMultiply(std::uint64_t a, std::uint64_t b, std::uint64_t& out) {
+    if (a != 0 && b > std::numeric_limits<std::uint64_t>::max() / a) {
+        return false;
+    }
+    out = a * b;
+    return true;
+}
+
+bool igesCurve(const std::vector<double>& values, const BezierSink& sink) {
+    // 126, K, M, PROP1-4, knots (K + M + 2), weights (K + 1), points, ...
+    if (values.size() < 7) {
+        return false;
+    }
+    // every count is below values.size(), the sums below cannot overflow
+    const std::uint64_t size = values.size();
+    std::uint64_t k = 0;
+    std::uint64_t m = 0;
+    if (!igesInteger(values[1], std::min<std::uint64_t>(size, UINT32_MAX - 1), k)
+        || !igesInteger(values[2], BEZIER_MAX_CP - 1, m)) {
+        return false;
+    }
+    const std::uint64_t knotCount = k + m + 2;
+    const std::uint64_t weights = 7 + knotCount;
+    const std::uint64_t points = weights + k + 1;
+    if (size < points + 3 * (k + 1)) {
+        return false;
+    }
+
+    NurbsCurve curve;
+    curve.degree = static_cast<GLuint>(m);
+    curve.knots.assign(values.begin() + 7, values.begin() + weights);
+    for (std::size_t i = 0; i <= k; ++i) {
+        const double* xyz = values.data() + points + 3 * i;
+        curve.points.emplace_back(float(xyz[0]), float(xyz[1]), float(xyz[2]),
+                                  float(values[weights + i]));
+    }
+    return decomposeToBezier(curve, sink);
+}
+
+bool igesSurface(const std::vector<double>& values, const BezierSink& sink) {
+    // 128, K1, K2, M1, M2, PROP1-5, knots S, knots T, weights, points, ...
+    if (values.size() < 10) {
+        return false;
+    }
+    const std::uint64_t size = values.size();
+    const std::uint64_t maxCount = std::min<std::uint64_t>(size, UINT32_MAX - 1);
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+    std::uint64_t m1 = 0;
+    std::uint64_t m2 = 0;
+    if (!igesInteger(values[1], maxCount, k1) || !igesInteger(values[2], maxCount, k2)
+        || !igesInteger(values[3], BEZIER_MAX_CP - 1, m1)
+        || !igesInteger(values[4], BEZIER_MAX_CP - 1, m2)) {
+        return false;
+    }
+    NurbsSurface net;
+    net.degreeU = static_cast<GLuint>(m1);
+    net.degreeV = static_cast<GLuint>(m2);
+    net.countU = static_cast<GLuint>(k1 + 1);
+    net.countV = static_cast<GLuint>(k2 + 1);
+
+    const std::uint64_t knotsS = 10;
+    const std::uint64_t knotsT = knotsS + k1 + m1 + 2;
+    const std::uint64_t weights = knotsT + k2 + m2 + 2;
+    std::uint64_t count = 0;
+    std::uint64_t coordinates = 0;
+    if (!checkedMultiply(k1 + 1, k2 + 1, count) || count > size
+        || !checkedMultiply(count, 4, coordinates)
+        || size < weights || size - weights < coordinates) {
+        return false;
+    }
+    const std::uint64_t points = weights + count;
+
+    net.knotsU.assign(values.begin() + knotsS, values.begin() + knotsT);
+    net.knotsV.assign(values.begin() + knotsT, values.begin() + weights);
+
+    // first index varies fastest
+    net.points.resize(count);
+    for (std::size_t iv = 0; iv <= k2; ++iv) {
+        for (std::size_t iu = 0; iu <= k1; ++iu) {
+            const std::size_t i = iv * (k1 + 1) + iu;
+            const double* xyz = values.data() + points + 3 * i;
+            net.points[iu * net.countV + iv] = ControlPoint(
+                    float(xyz[0]), float(xyz[1]), float(xyz[2]),
+                    float(values[weights + i])
+            );
+        }
+    }
+    return decomposeToBezier(net, sink);
+}
+
+/**
+ * Delimiters of the global section, written as 1Hx when they are not the
+ * default ',' and ';'.
+ */
+void igesDelimiters(const std::string& global, char& parameter, char& record) {
+    parameter = ',';
+    record = ';';
+    std::size_t p = 0;
+    if (global.compare(0, 2, "1H") == 0 && global.size() > 2) {
+        parameter = global[2];
+        p = 3;
+    }
+    if (p < global.size() && global[p] == parameter) {
+        ++p;
+    }
+    if (global.compare(p, 2, "1H") == 0 && global.size() > p + 2) {
+        record = global[p + 2];
+    }
+}
+
+} // namespace
+
+
+bool importObj(const std::string& path, const BezierSink& sink,
+               const std::atomic<bool>* cancel) {
+    ChunkedLineReader reader(true);
+    if (!reader.open(path)) {
+        return false;
+    }
+    ObjParser parser(sink);
+    return parser.parse(reader, cancel);
+}
+
+bool importIges(const std::string& path, const BezierSink& sink,
+                const std::atomic<bool>* cancel) {
+    ChunkedLineReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    constexpr std::size_t sectionColumn = 72;
+    constexpr std::size_t parameterColumns = 64;
+
+    std::string global;
+    std::string record;
+    std::vector<double> values;
+    char parameterDelimiter = ',';
+    char recordDelimiter = ';';
+    bool delimitersKnown = false;
+    std::size_t skipped = 0;
+
+    TextSpan text;
+    while (!cancelled(cancel) && reader.nextLine(text)) {
+        if (text.size() <= sectionColumn) {
+            continue;
+        }
+        const char section = text.begin[sectionColumn];
+
+        if (section == 'G') {
+            global.append(text.begin, sectionColumn);
+            continue;
+        }
+        if (section != 'P') {
+            continue;
+        }
+        if (!delimitersKnown) {
+            igesDelimiters(global, parameterDelimiter, recordDelimiter);
+            delimitersKnown = true;
+        }
+
+        record.append(text.begin, parameterColumns);
+        const std::size_t end = record.find(recordDelimiter);
+        if (end == std::string::npos) {
+            continue;
+        }
+        record.resize(end);
+
+        bool ok = igesParameters(record, parameterDelimiter, values)
+                  && !values.empty();
+        if (ok && values[0] == 126.) {
+            ok = igesCurve(values, sink);
+        } else if (ok && values[0] == 128.) {
+            ok = igesSurface(values, sink);
+        }
+        if (!ok) {
+            ++skipped;
+        }
+        record.clear();
+    }
+
+    if (skipped > 0) {
+        std::cerr << "IGES: " << skipped << " entity(ies) skipped" << std::endl;
+    }
+    return true;
+}
+
+bool importControlNets(const std::string& path, const BezierSink& sink,
+                       const std::atomic<bool>* cancel) {
+    if (hasExtension(path, "obj")) {
+        return importObj(path, sink, cancel);
+    }
+    if (hasExtension(path, "igs") || hasExtension(path, "iges")) {
+        return importIges(path, sink, cancel);
+    }
+    std::cerr << "Unknown control net format '" << path << "'" << std::endl;
+    return false;
+}
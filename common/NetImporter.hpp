@@ -0,0 +1,39 @@
+#ifndef BEZIER_NET_IMPORTER_HPP
+#define BEZIER_NET_IMPORTER_HPP
+
+#include "Nurbs.hpp"
+
+#include <atomic>
+#include <string>
+
+/**
+ * Streaming importers of control nets stored as text. The file is read by
+ * chunks and every Bezier segment or patch is handed to the sink as soon as
+ * the element it comes from is parsed, B-splines being split on the fly.
+ * Setting cancel stops the import at the next line. They return false if
+ * the file could not be read; unsupported or invalid elements are reported
+ * and skipped.
+ */
+
+/**
+ * Wavefront OBJ free-form geometry: v, cstype [rat] bezier|bmatrix|bspline,
+ * deg, bmat, step, curv, surf, parm and end. Trimming curves and the
+ * cardinal/taylor bases are ignored.
+ */
+bool importObj(const std::string& path, const BezierSink& sink,
+               const std::atomic<bool>* cancel = nullptr);
+
+/**
+ * IGES subset: the rational B-spline curves (126) and surfaces (128) of the
+ * parameter data section, with the delimiters of the global section.
+ */
+bool importIges(const std::string& path, const BezierSink& sink,
+                const std::atomic<bool>* cancel = nullptr);
+
+/**
+ * Pick the importer from the extension (.obj, .igs/.iges).
+ */
+bool importControlNets(const std::string& path, const BezierSink& sink,
+                       const std::atomic<bool>* cancel = nullptr);
+
+#endif //BEZIER_NET_IMPORTER_HPP
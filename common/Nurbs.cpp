@@ -0,0 +1,237 @@
+#include "Nurbs.hpp"
+
+#include "Bezier.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+using HPoint = Homogeneous<double>;
+using HPoints = std::vector<HPoint, Eigen::aligned_allocator<HPoint>>;
+
+bool validKnots(const std::vector<double>& knots, std::size_t count,
+                GLuint degree, const char* what) {
+    if (degree < 1 || degree + 1 > BEZIER_MAX_CP || count < degree + 1) {
+        std::cerr << "NURBS " << what << ": invalid degree " << degree
+                  << " for " << count << " control points" << std::endl;
+        return false;
+    }
+    if (knots.size() != count + degree + 1) {
+        std::cerr << "NURBS " << what << ": expected " << count + degree + 1
+                  << " knots, got " << knots.size() << std::endl;
+        return false;
+    }
+    if (!std::is_sorted(knots.begin(), knots.end())) {
+        std::cerr << "NURBS " << what << ": knots are not sorted" << std::endl;
+        return false;
+    }
+    for (GLuint i = 1; i <= degree; ++i) {
+        if (knots[i] != knots[0] || knots[knots.size() - 1 - i] != knots.back()) {
+            std::cerr << "NURBS " << what << ": knot vector is not clamped"
+                      << std::endl;
+            return false;
+        }
+    }
+    // decompose raises the internal knots to multiplicity p, they cannot
+    // already be above it (nor extend the clamped ends)
+    for (std::size_t i = degree + 1; i < count;) {
+        std::size_t j = i + 1;
+        while (j < count && knots[j] == knots[i]) {
+            ++j;
+        }
+        if (knots[i] == knots.front() || knots[i] == knots.back()
+            || j - i > degree) {
+            std::cerr << "NURBS " << what << ": knot " << knots[i]
+                      << " is repeated too many times for degree " << degree
+                      << std::endl;
+            return false;
+        }
+        i = j;
+    }
+    return true;
+}
+
+/**
+ * Piegl & Tiller, The NURBS Book, A5.6: every internal knot is inserted up
+ * to multiplicity p. Two segment buffers are enough, each segment is handed
+ * to emit before building the next one.
+ */
+template <typename Emit>
+void decompose(const HPoint* pw, std::size_t stride, std::size_t count,
+               GLuint p, const std::vector<double>& knots, const Emit& emit) {
+    const std::size_t m = count + p;
+    std::size_t a = p;
+    std::size_t b = p + 1;
+
+    HPoint current[BEZIER_MAX_CP];
+    HPoint next[BEZIER_MAX_CP];
+    double alphas[BEZIER_MAX_CP];
+
+    for (std::size_t i = 0; i <= p; ++i) {
+        current[i] = pw[i * stride];
+    }
+
+    while (b < m) {
+        const std::size_t i = b;
+        while (b < m && knots[b + 1] == knots[b]) {
+            ++b;
+        }
+        const std::size_t mult = b - i + 1;
+
+        if (mult < p) {
+            const double numer = knots[b] - knots[a];
+            for (std::size_t j = p; j > mult; --j) {
+                alphas[j - mult - 1] = numer / (knots[a + j] - knots[a]);
+            }
+            const std::size_t r = p - mult;
+            for (std::size_t j = 1; j <= r; ++j) {
+                const std::size_t save = r - j;
+                const std::size_t s = mult + j;
+                for (std::size_t k = p; k >= s; --k) {
+                    const double alpha = alphas[k - s];
+                    current[k] = alpha * current[k] + (1. - alpha) * current[k - 1];
+                }
+                if (b < m) {
+                    next[save] = current[p];
+                }
+            }
+        }
+
+        emit(current);
+
+        if (b < m) {
+            for (std::size_t k = p - mult; k <= p; ++k) {
+                next[k] = pw[(b - p + k) * stride];
+            }
+            std::copy(next, next + p + 1, current);
+            a = b;
+            ++b;
+        }
+    }
+}
+
+HPoints homogeneousPoints(const std::vector<ControlPoint>& points) {
+    HPoints hpoints;
+    hpoints.reserve(points.size());
+    for (const auto& cp : points) {
+        hpoints.push_back(toHomogeneous<double>(
+                cp.position.cast<double>(), double(cp.weight)
+        ));
+    }
+    return hpoints;
+}
+
+ControlPoint toControlPoint(const HPoint& p) {
+    return ControlPoint(fromHomogeneous(p).cast<float>(), float(p.w()));
+}
+
+} // namespace
+
+
+bool decomposeToBezier(const NurbsCurve& curve, const BezierSink& sink) {
+    if (!validKnots(curve.knots, curve.points.size(), curve.degree, "curve")) {
+        return false;
+    }
+
+    const HPoints hpoints = homogeneousPoints(curve.points);
+    const GLuint p = curve.degree;
+
+    ControlPoint segment[BEZIER_MAX_CP];
+    decompose(hpoints.data(), 1, hpoints.size(), p, curve.knots,
+              [&](const HPoint* bezier) {
+                  for (GLuint i = 0; i <= p; ++i) {
+                      segment[i] = toControlPoint(bezier[i]);
+                  }
+                  sink(segment, p + 1, 1);
+              });
+    return true;
+}
+
+bool decomposeToBezier(const NurbsSurface& surface, const BezierSink& sink) {
+    if (surface.points.size() != std::size_t(surface.countU) * surface.countV) {
+        std::cerr << "NURBS surface: expected " << surface.countU * surface.countV
+                  << " control points, got " << surface.points.size() << std::endl;
+        return false;
+    }
+    if (!validKnots(surface.knotsU, surface.countU, surface.degreeU, "surface (u)")
+        || !validKnots(surface.knotsV, surface.countV, surface.degreeV, "surface (v)")) {
+        return false;
+    }
+
+    const HPoints hpoints = homogeneousPoints(surface.points);
+    const GLuint pu = surface.degreeU;
+    const GLuint pv = surface.degreeV;
+    const std::size_t nv = surface.countV;
+
+    // u direction: each column of constant iv is split, giving for every
+    // u segment a (pu + 1) x nv net stored like the input
+    std::vector<HPoints> uSegments;
+    for (std::size_t iv = 0; iv < nv; ++iv) {
+        std::size_t segment = 0;
+        decompose(hpoints.data() + iv, nv, surface.countU, pu, surface.knotsU,
+                  [&](const HPoint* bezier) {
+                      if (segment == uSegments.size()) {
+                          uSegments.emplace_back((pu + 1) * nv);
+                      }
+                      for (std::size_t iu = 0; iu <= pu; ++iu) {
+                          uSegments[segment][iu * nv + iv] = bezier[iu];
+                      }
+                      ++segment;
+                  });
+    }
+
+    // v direction: the rows of each u segment are split and gathered into
+    // (pu + 1) x (pv + 1) patches
+    std::vector<ControlPoint> patch((pu + 1) * (pv + 1));
+    std::vector<HPoints> vSegments;
+    for (const auto& net : uSegments) {
+        vSegments.clear();
+        for (std::size_t iu = 0; iu <= pu; ++iu) {
+            std::size_t segment = 0;
+            decompose(net.data() + iu * nv, 1, nv, pv, surface.knotsV,
+                      [&](const HPoint* bezier) {
+                          if (segment == vSegments.size()) {
+                              vSegments.emplace_back((pu + 1) * (pv + 1));
+                          }
+                          std::copy(bezier, bezier + pv + 1,
+                                    vSegments[segment].begin() + iu * (pv + 1));
+                          ++segment;
+                      });
+        }
+        for (const auto& bezier : vSegments) {
+            std::transform(bezier.begin(), bezier.end(), patch.begin(),
+                           toControlPoint);
+            sink(patch.data(), pu + 1, pv + 1);
+        }
+    }
+    return true;
+}
+
+std::size_t convertToBezier(const std::vector<NurbsCurve>& curves,
+                            const std::vector<NurbsSurface>& surfaces,
+                            const BezierSink& sink,
+                            unsigned threadCount) {
+    std::mutex sinkMutex;
+    const BezierSink serializedSink = [&](const ControlPoint* points,
+                                          GLuint countU, GLuint countV) {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        sink(points, countU, countV);
+    };
+
+    std::atomic<std::size_t> failures(0);
+    parallelFor(curves.size() + surfaces.size(), 1, threadCount,
+                [&](std::size_t e, std::size_t, unsigned) {
+                    const bool ok = e < curves.size()
+                            ? decomposeToBezier(curves[e], serializedSink)
+                            : decomposeToBezier(surfaces[e - curves.size()],
+                                                serializedSink);
+                    if (!ok) {
+                        ++failures;
+                    }
+                });
+    return failures;
+}
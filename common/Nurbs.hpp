@@ -0,0 +1,62 @@
+#ifndef BEZIER_NURBS_HPP
+#define BEZIER_NURBS_HPP
+
+#include "ControlPoint.hpp"
+
+#include <functional>
+
+/**
+ * Non uniform rational B-spline curve. The knot vector must be clamped
+ * (degree + 1 equal knots at both ends) and hold points.size() + degree + 1
+ * values.
+ */
+struct NurbsCurve {
+    GLuint degree;
+    std::vector<double> knots;
+    std::vector<ControlPoint> points;
+};
+
+/**
+ * NURBS surface. Control point (iu, iv) is at iu * countV + iv, like the
+ * Bezier patches of the pool.
+ */
+struct NurbsSurface {
+    GLuint degreeU;
+    GLuint degreeV;
+    GLuint countU;
+    GLuint countV;
+    std::vector<double> knotsU;
+    std::vector<double> knotsV;
+    std::vector<ControlPoint> points;
+};
+
+/**
+ * Receives each Bezier segment (countV == 1) or patch as soon as it is built.
+ * The points are only valid during the call.
+ */
+using BezierSink = std::function<void(const ControlPoint* points,
+                                      GLuint countU, GLuint countV)>;
+
+/**
+ * Split a NURBS curve into its Bezier segments by knot insertion (Boehm) up
+ * to full multiplicity. Returns false if the curve is not valid.
+ */
+bool decomposeToBezier(const NurbsCurve& curve, const BezierSink& sink);
+
+/**
+ * Split a NURBS surface into its Bezier patches, along u then along v.
+ */
+bool decomposeToBezier(const NurbsSurface& surface, const BezierSink& sink);
+
+/**
+ * Decompose every entity using threadCount workers (0: hardware
+ * concurrency). Each worker converts a whole entity and streams its patches
+ * to the sink; calls to the sink are serialized but come in no particular
+ * order. Returns the number of entities that could not be converted.
+ */
+std::size_t convertToBezier(const std::vector<NurbsCurve>& curves,
+                            const std::vector<NurbsSurface>& surfaces,
+                            const BezierSink& sink,
+                            unsigned threadCount = 0);
+
+#endif //BEZIER_NURBS_HPP
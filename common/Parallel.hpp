@@ -0,0 +1,59 @@
+#ifndef BEZIER_PARALLEL_HPP
+#define BEZIER_PARALLEL_HPP
+
+#include "easycppogl_src/trace_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of workers to use for a number of independent jobs, requested == 0
+ * meaning hardware concurrency.
+ */
+inline unsigned workerCount(unsigned requested, std::size_t jobs) {
+    if (requested == 0) {
+        requested = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(
+            std::max<std::size_t>(1, std::min<std::size_t>(requested, jobs))
+    );
+}
+
+/**
+ * Call fn(begin, end, worker) on chunks of [0, count) from threadCount
+ * workers (0: hardware concurrency), the calling thread being worker 0.
+ * Chunks are taken from an atomic counter, so uneven jobs balance
+ * themselves; worker indices let fn use per worker scratch data.
+ */
+template <typename Fn>
+void parallelFor(std::size_t count, std::size_t chunk, unsigned threadCount,
+                 const Fn& fn) {
+    chunk = std::max<std::size_t>(chunk, 1);
+    threadCount = workerCount(threadCount, (count + chunk - 1) / chunk);
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&](unsigned index) {
+        EZCOGL::TraceZone zone("parallelFor");
+        for (std::size_t begin = next.fetch_add(chunk); begin < count;
+             begin = next.fetch_add(chunk)) {
+            fn(begin, std::min(begin + chunk, count), index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned t = 1; t < threadCount; ++t) {
+        threads.emplace_back([&worker, t]() {
+            EZCOGL::TraceProfiler::set_thread_name("parallelFor worker");
+            worker(t);
+        });
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif //BEZIER_PARALLEL_HPP
@@ -0,0 +1,47 @@
+#include "PatchBatches.hpp"
+
+#include <algorithm>
+
+PatchBatches::PatchBatches() :
+        generation(0),
+        batchedCount(0),
+        changeCount(0) {
+}
+
+void PatchBatches::update(const PatchPool& pool) {
+    if (pool.generation() != generation || pool.patchCount() < batchedCount) {
+        sorted.clear();
+        keys.clear();
+        generation = pool.generation();
+        batchedCount = 0;
+        ++changeCount;
+    }
+
+    const auto& patches = pool.patches();
+    if (batchedCount < patches.size()) {
+        ++changeCount;
+    }
+    for (; batchedCount < patches.size(); ++batchedCount) {
+        const auto& patch = patches[batchedCount];
+        auto& target = batch(patch.countU, patch.countV);
+        target.firsts.push_back(static_cast<GLint>(patch.first));
+        target.counts.push_back(static_cast<GLsizei>(patch.count()));
+    }
+}
+
+std::uint64_t PatchBatches::key(GLuint countU, GLuint countV) {
+    const std::uint64_t surface = countV == 1 ? 0 : 1;
+    return surface << 63 | std::uint64_t(countU) << 32 | countV;
+}
+
+PatchBatch& PatchBatches::batch(GLuint countU, GLuint countV) {
+    const auto k = key(countU, countV);
+    const auto position = std::lower_bound(keys.begin(), keys.end(), k);
+    const auto index = position - keys.begin();
+    if (position == keys.end() || *position != k) {
+        // a new size, rare: the batches after it are moved
+        keys.insert(position, k);
+        sorted.insert(sorted.begin() + index, PatchBatch{countU, countV, {}, {}});
+    }
+    return sorted[index];
+}
@@ -0,0 +1,67 @@
+#ifndef BEZIER_PATCH_BATCHES_HPP
+#define BEZIER_PATCH_BATCHES_HPP
+
+#include "PatchPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Patches of one size (so one GL_PATCH_VERTICES and one shader variant),
+ * drawn with a single glMultiDrawArrays.
+ */
+struct PatchBatch {
+    GLuint countU;
+    GLuint countV;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+
+    inline bool isCurve() const { return countV == 1; }
+    inline GLsizei patchVertices() const { return countU * countV; }
+    inline GLsizei size() const { return static_cast<GLsizei>(firsts.size()); }
+
+    /**
+     * Draw every patch of the batch (GL_PATCHES, or GL_LINE_STRIP for the
+     * control polygons of curves for instance).
+     */
+    inline void draw(GLenum mode) const {
+        glMultiDrawArrays(mode, firsts.data(), counts.data(), size());
+    }
+};
+
+/**
+ * Draw scheduler: the patches of a pool bucketed by size. The batches are
+ * sorted (curves first, then by countU and countV) so a frame changes the
+ * program and the patch size once per batch instead of once per patch.
+ */
+class PatchBatches {
+public:
+    PatchBatches();
+
+    /**
+     * Bring the batches up to date with pool: only the patches appended
+     * since the last update are bucketed, unless the pool was replaced.
+     */
+    void update(const PatchPool& pool);
+
+    inline const std::vector<PatchBatch>& batches() const { return sorted; }
+
+    /**
+     * Changes each time update modifies the batches.
+     */
+    inline std::uint64_t revision() const { return changeCount; }
+
+private:
+    static std::uint64_t key(GLuint countU, GLuint countV);
+
+    PatchBatch& batch(GLuint countU, GLuint countV);
+
+    std::vector<PatchBatch> sorted;
+    std::vector<std::uint64_t> keys;
+
+    std::uint64_t generation;
+    std::size_t batchedCount;
+    std::uint64_t changeCount;
+};
+
+#endif //BEZIER_PATCH_BATCHES_HPP
@@ -0,0 +1,76 @@
+#include "PatchDependencies.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace {
+    inline std::tuple<float, float, float> positionKey(const ControlPoint& point) {
+        return std::make_tuple(point.position.x(), point.position.y(),
+                               point.position.z());
+    }
+}
+
+PatchDependencies::PatchDependencies() :
+        generation(0),
+        mappedPoints(0) {
+}
+
+bool PatchDependencies::update(const PatchPool& pool) {
+    if (!pool.isResident()) {
+        return false;
+    }
+    const auto& points = pool.controlPoints().points();
+    if (pool.generation() == generation && points.size() == mappedPoints) {
+        return true;
+    }
+    generation = pool.generation();
+    mappedPoints = points.size();
+
+    pointPatches.assign(points.size(), 0);
+    const auto& patches = pool.patches();
+    for (std::size_t p = 0; p < patches.size(); ++p) {
+        const auto& patch = patches[p];
+        std::fill_n(pointPatches.begin() + patch.first, patch.count(),
+                    static_cast<GLuint>(p));
+    }
+
+    // the copies of a point are exact, they are sorted next to each other
+    groupPoints.resize(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        groupPoints[i] = static_cast<GLuint>(i);
+    }
+    std::sort(groupPoints.begin(), groupPoints.end(),
+              [&points](GLuint a, GLuint b) {
+                  const auto keyA = positionKey(points[a]);
+                  const auto keyB = positionKey(points[b]);
+                  return keyA < keyB || (keyA == keyB && a < b);
+              });
+
+    pointGroups.resize(points.size());
+    groupOffsets.clear();
+    for (std::size_t i = 0; i < groupPoints.size(); ++i) {
+        if (i == 0 || positionKey(points[groupPoints[i]])
+                      != positionKey(points[groupPoints[i - 1]])) {
+            groupOffsets.push_back(static_cast<GLuint>(i));
+        }
+        pointGroups[groupPoints[i]] = static_cast<GLuint>(groupOffsets.size() - 1);
+    }
+    groupOffsets.push_back(static_cast<GLuint>(groupPoints.size()));
+    return true;
+}
+
+void PatchDependencies::coincident(GLuint point, std::vector<GLuint>& points) const {
+    const GLuint group = pointGroups[point];
+    points.assign(groupPoints.begin() + groupOffsets[group],
+                  groupPoints.begin() + groupOffsets[group + 1]);
+}
+
+void PatchDependencies::patchesOf(const std::vector<GLuint>& points,
+                                  std::vector<GLuint>& patches) const {
+    patches.clear();
+    for (const GLuint point : points) {
+        patches.push_back(pointPatches[point]);
+    }
+    std::sort(patches.begin(), patches.end());
+    patches.erase(std::unique(patches.begin(), patches.end()), patches.end());
+}
@@ -0,0 +1,56 @@
+#ifndef BEZIER_PATCH_DEPENDENCIES_HPP
+#define BEZIER_PATCH_DEPENDENCIES_HPP
+
+#include "PatchPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Which patches of a pool depend on each control point, for edits to only
+ * redo the patches they touch.
+ *
+ * Adjacent patches keep their own copy of the points of their common
+ * boundary, so the points at the same position are grouped: moving a point
+ * moves its whole group, and the patches of every point of the group change.
+ */
+class PatchDependencies {
+public:
+    PatchDependencies();
+
+    /**
+     * Bring the map up to date with pool, rebuilt if patches were replaced
+     * or appended. Needs the CPU copy of the control points, returns false
+     * without it.
+     */
+    bool update(const PatchPool& pool);
+
+    /**
+     * Patch owning the point.
+     */
+    inline GLuint patchOf(GLuint point) const { return pointPatches[point]; }
+
+    /**
+     * The points at the position of point, itself included, in increasing
+     * order.
+     */
+    void coincident(GLuint point, std::vector<GLuint>& points) const;
+
+    /**
+     * The patches using any of the points, sorted and without duplicates.
+     */
+    void patchesOf(const std::vector<GLuint>& points,
+                   std::vector<GLuint>& patches) const;
+
+private:
+    std::uint64_t generation;
+    std::size_t mappedPoints;
+
+    std::vector<GLuint> pointPatches;
+    // the points of group g are groupPoints[groupOffsets[g], groupOffsets[g + 1])
+    std::vector<GLuint> pointGroups;
+    std::vector<GLuint> groupOffsets;
+    std::vector<GLuint> groupPoints;
+};
+
+#endif //BEZIER_PATCH_DEPENDENCIES_HPP
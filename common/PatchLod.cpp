@@ -0,0 +1,305 @@
+#include "PatchLod.hpp"
+
+#include "Bezier.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+    using HPoints = std::vector<Homogeneous<float>,
+                                Eigen::aligned_allocator<Homogeneous<float>>>;
+
+    constexpr std::size_t PATCHES_PER_JOB = 64;
+
+    struct Bounds {
+        GLVec3 center;
+        GLfloat radius;
+    };
+
+    inline bool hasLevels(const PatchRecord& patch) {
+        return !patch.isCurve() && patch.countU <= BEZIER_MAX_CP
+               && patch.countV <= BEZIER_MAX_CP;
+    }
+
+    /**
+     * Sample patch at every level, level l starting at block + offsets[l].
+     * Returns the sphere bounding the control points, which contains the
+     * patch.
+     */
+    template <std::size_t N>
+    Bounds sampleLevels(const std::vector<ControlPoint>& points, const PatchRecord& patch,
+                        const std::array<GLuint, N>& levels,
+                        const std::array<GLint, N>& offsets,
+                        HPoints& controlPoints, GLVec3* block) {
+        GLVec3 lower = GLVec3::Constant(std::numeric_limits<float>::max());
+        GLVec3 upper = -lower;
+        controlPoints.resize(patch.count());
+        for (GLuint i = 0; i < patch.count(); ++i) {
+            const auto& point = points[patch.first + i];
+            controlPoints[i] = point.homogeneous();
+            lower = lower.cwiseMin(point.position);
+            upper = upper.cwiseMax(point.position);
+        }
+        Bounds bounds{(lower + upper) / 2.f, 0.f};
+        for (GLuint i = 0; i < patch.count(); ++i) {
+            bounds.radius = std::max(bounds.radius,
+                                     (points[patch.first + i].position - bounds.center).norm());
+        }
+
+        for (std::size_t l = 0; l < N; ++l) {
+            const std::size_t side = levels[l] + 1;
+            samplePatch(controlPoints.data(), patch.countU, patch.countV,
+                        side, side, block + offsets[l]);
+        }
+        return bounds;
+    }
+
+    /**
+     * Triangles of a level x level grid, vertex (i, j) being at j * side + i,
+     * counter clockwise in (u, v) like the tessellation shaders.
+     */
+    void gridTriangles(GLuint level, std::vector<GLuint>& indices) {
+        const GLuint side = level + 1;
+        for (GLuint j = 0; j < level; ++j) {
+            for (GLuint i = 0; i < level; ++i) {
+                const GLuint a = j * side + i;
+                indices.insert(indices.end(), {a, a + 1, a + side + 1,
+                                               a, a + side + 1, a + side});
+            }
+        }
+    }
+}
+
+constexpr std::array<GLuint, 4> PatchLod::LEVELS;
+
+PatchLod::PatchLod(BufferPool& buffers) :
+        buffers(buffers),
+        vaoRevision(0),
+        indexRange{0, 0},
+        vertexBytes(0),
+        generation(0),
+        tessellatedCount(0),
+        patchVertices(0),
+        drawn{} {
+    GLuint indexCount = 0;
+    for (std::size_t l = 0; l < LEVELS.size(); ++l) {
+        const GLint side = static_cast<GLint>(LEVELS[l] + 1);
+        vertexOffsets[l] = patchVertices;
+        patchVertices += side * side;
+        indexOffsets[l] = indexCount;
+        indexCounts[l] = static_cast<GLsizei>(6 * LEVELS[l] * LEVELS[l]);
+        indexCount += static_cast<GLuint>(indexCounts[l]);
+    }
+}
+
+PatchLod::~PatchLod() {
+    releaseVertices();
+    buffers.release(indexRange);
+}
+
+void PatchLod::releaseVertices() {
+    for (const auto& range : vertexRanges) {
+        buffers.release(range);
+    }
+    vertexRanges.clear();
+    vertexBytes = 0;
+}
+
+bool PatchLod::update(const PatchPool& pool) {
+    if (pool.generation() != generation || pool.patchCount() < tessellatedCount) {
+        // the ranges go back to the pool, no buffer is deleted
+        lodPatches.clear();
+        slots.clear();
+        releaseVertices();
+        tessellatedCount = 0;
+        generation = pool.generation();
+    }
+    const auto& patches = pool.patches();
+    if (tessellatedCount == patches.size()) {
+        return true;
+    }
+    if (!pool.isResident()) {
+        return false;
+    }
+
+    if (!indexRange.valid()) {
+        std::vector<GLuint> indices;
+        for (const GLuint level : LEVELS) {
+            gridTriangles(level, indices);
+        }
+        const auto bytes = static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint));
+        indexRange = buffers.allocate(bytes, sizeof(GLuint));
+        buffers.sub_data(indexRange.offset, bytes, indices.data());
+    }
+
+    std::vector<const PatchRecord*> added;
+    slots.resize(patches.size(), -1);
+    for (std::size_t i = tessellatedCount; i < patches.size(); ++i) {
+        if (hasLevels(patches[i])) {
+            slots[i] = static_cast<GLint>(lodPatches.size() + added.size());
+            added.push_back(&patches[i]);
+        }
+    }
+    tessellatedCount = patches.size();
+    if (added.empty()) {
+        return true;
+    }
+
+    // aligned on a vertex, so the offset of the range is a base vertex
+    const auto bytes = static_cast<GLsizeiptr>(added.size() * patchVertices * sizeof(GLVec3));
+    const auto range = buffers.allocate(bytes, sizeof(GLVec3));
+    vertexRanges.push_back(range);
+    vertexBytes += static_cast<std::size_t>(bytes);
+    const auto firstVertex = static_cast<GLint>(range.offset / GLintptr(sizeof(GLVec3)));
+
+    const auto& points = pool.controlPoints().points();
+    std::vector<GLVec3> vertices(added.size() * patchVertices);
+    std::vector<LodPatch> addedPatches(added.size());
+
+    parallelFor(added.size(), PATCHES_PER_JOB, 0,
+                [&](std::size_t begin, std::size_t end, unsigned) {
+        HPoints controlPoints;
+        for (std::size_t p = begin; p < end; ++p) {
+            const Bounds bounds = sampleLevels(points, *added[p], LEVELS, vertexOffsets,
+                                               controlPoints,
+                                               vertices.data() + p * patchVertices);
+            addedPatches[p] = {bounds.center, bounds.radius,
+                               firstVertex + static_cast<GLint>(p) * patchVertices};
+        }
+    });
+
+    buffers.sub_data(range.offset, bytes, vertices.data());
+    lodPatches.insert(lodPatches.end(), addedPatches.begin(), addedPatches.end());
+    return true;
+}
+
+void PatchLod::retessellate(const PatchPool& pool, const std::vector<GLuint>& patches) {
+    if (lodPatches.empty() || !pool.isResident() || pool.generation() != generation) {
+        return;
+    }
+    const auto& points = pool.controlPoints().points();
+    HPoints controlPoints;
+    std::vector<GLVec3> vertices(patchVertices);
+
+    for (const GLuint index : patches) {
+        if (index >= slots.size() || slots[index] < 0) {
+            continue;
+        }
+        auto& lodPatch = lodPatches[slots[index]];
+        const Bounds bounds = sampleLevels(points, pool.patches()[index], LEVELS,
+                                           vertexOffsets, controlPoints,
+                                           vertices.data());
+        lodPatch.center = bounds.center;
+        lodPatch.radius = bounds.radius;
+        buffers.sub_data(static_cast<GLintptr>(lodPatch.baseVertex * sizeof(GLVec3)),
+                         static_cast<GLsizeiptr>(vertices.size() * sizeof(GLVec3)),
+                         vertices.data());
+    }
+}
+
+void PatchLod::draw(const GLMat4& projection, const GLMat4& modelview,
+                    GLint viewportHeight, float maxSegmentPixels,
+                    FrameArena& arena) {
+    drawn.fill(0);
+    if (lodPatches.empty()) {
+        return;
+    }
+
+    // the pool moved to a larger buffer, the indices are read from it too
+    if (!vao || vaoRevision != buffers.revision()) {
+        const auto& vbo = buffers.vbo();
+        const auto vertices = static_cast<GLuint>(buffers.capacity()
+                                                  / GLsizeiptr(sizeof(GLVec3)));
+        vao = VAO::create(vbo, vertices, {{0, 3, GL_FLOAT, GL_FALSE, sizeof(GLVec3), 0}});
+        vao->bind();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->id());
+        VAO::unbind();
+        vaoRevision = buffers.revision();
+    }
+
+    // frustum planes in model space (Gribb and Hartmann), normalized so
+    // that the sphere test is a distance
+    const GLMat4 mvp = projection * modelview;
+    GLVec4 planes[6];
+    for (int axis = 0; axis < 3; ++axis) {
+        planes[2 * axis] = mvp.row(3).transpose() + mvp.row(axis).transpose();
+        planes[2 * axis + 1] = mvp.row(3).transpose() - mvp.row(axis).transpose();
+    }
+    for (auto& plane : planes) {
+        plane /= plane.head<3>().norm();
+    }
+
+    const bool orthographic = projection(3, 3) == 1.f;
+    const float scale = modelview.block<3, 1>(0, 0).norm();
+    const float pixelsPerUnit = projection(1, 1) * 0.5f * static_cast<float>(viewportHeight);
+
+    // level of each visible patch, then the draw lists grouped by level:
+    // the sizes are known before filling them, each list is one allocation
+    FrameVector<GLuint> visible{ArenaAllocator<GLuint>(arena)};
+    FrameVector<GLubyte> levels{ArenaAllocator<GLubyte>(arena)};
+    visible.reserve(lodPatches.size());
+    levels.reserve(lodPatches.size());
+    for (std::size_t p = 0; p < lodPatches.size(); ++p) {
+        const auto& patch = lodPatches[p];
+        const GLVec4 center(patch.center.x(), patch.center.y(), patch.center.z(), 1.f);
+        bool inside = true;
+        for (const auto& plane : planes) {
+            inside = inside && plane.dot(center) >= -patch.radius;
+        }
+        if (!inside) {
+            continue;
+        }
+
+        // diameter of the bounding sphere on screen
+        const float radius = patch.radius * scale;
+        const float depth = -(modelview.row(2).dot(center));
+        float pixels = 2.f * radius * pixelsPerUnit;
+        if (!orthographic) {
+            pixels = depth > radius ? pixels / depth
+                                    : std::numeric_limits<float>::max();
+        }
+
+        std::size_t l = 0;
+        while (l + 1 < LEVELS.size() && pixels > maxSegmentPixels * LEVELS[l]) {
+            ++l;
+        }
+        visible.push_back(static_cast<GLuint>(p));
+        levels.push_back(static_cast<GLubyte>(l));
+        ++drawn[l];
+    }
+
+    std::array<std::size_t, LEVELS.size()> firsts;
+    std::size_t first = 0;
+    for (std::size_t l = 0; l < LEVELS.size(); ++l) {
+        firsts[l] = first;
+        first += static_cast<std::size_t>(drawn[l]);
+    }
+    FrameVector<GLsizei> counts(visible.size(), 0, ArenaAllocator<GLsizei>(arena));
+    FrameVector<const void*> offsets(visible.size(), nullptr,
+                                     ArenaAllocator<const void*>(arena));
+    FrameVector<GLint> baseVertices(visible.size(), 0, ArenaAllocator<GLint>(arena));
+    auto next = firsts;
+    for (std::size_t i = 0; i < visible.size(); ++i) {
+        const std::size_t l = levels[i];
+        const std::size_t slot = next[l]++;
+        counts[slot] = indexCounts[l];
+        offsets[slot] = reinterpret_cast<const void*>(
+                static_cast<std::uintptr_t>(indexRange.offset)
+                + static_cast<std::uintptr_t>(indexOffsets[l]) * sizeof(GLuint)
+        );
+        baseVertices[slot] = lodPatches[visible[i]].baseVertex + vertexOffsets[l];
+    }
+
+    vao->bind();
+    for (std::size_t l = 0; l < LEVELS.size(); ++l) {
+        if (drawn[l] > 0) {
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data() + firsts[l],
+                                          GL_UNSIGNED_INT, offsets.data() + firsts[l],
+                                          drawn[l], baseVertices.data() + firsts[l]);
+        }
+    }
+    vao->unbind();
+}
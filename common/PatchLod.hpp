@@ -0,0 +1,106 @@
+#ifndef BEZIER_PATCH_LOD_HPP
+#define BEZIER_PATCH_LOD_HPP
+
+#include "PatchPool.hpp"
+
+#include "easycppogl_src/buffer_pool.h"
+#include "easycppogl_src/frame_arena.h"
+#include "easycppogl_src/vao.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Pre-tessellated levels of detail of the rectangular patches of a pool,
+ * an alternative to the tessellation shaders with no tessellation work per
+ * frame.
+ *
+ * Every patch is evaluated on grids of each level once, on the CPU, and the
+ * vertices stored in ranges of a BufferPool shared with other objects; all
+ * the patches of a level share the same triangles, stored once in the pool
+ * too and offset by a base vertex. Each
+ * frame, the level of a patch is chosen from the projected size of the
+ * sphere bounding its control points, and each level is drawn by a single
+ * glMultiDrawElementsBaseVertex.
+ */
+class PatchLod {
+public:
+    // segments per patch edge of each level
+    static constexpr std::array<GLuint, 4> LEVELS{{2, 4, 8, 16}};
+
+    explicit PatchLod(BufferPool& buffers);
+    ~PatchLod();
+
+    PatchLod(const PatchLod&) = delete;
+    PatchLod& operator=(const PatchLod&) = delete;
+
+    /**
+     * Tessellate the patches appended to pool since the last update (every
+     * patch if it was replaced). Needs the CPU copy of the control points,
+     * returns false without it.
+     */
+    bool update(const PatchPool& pool);
+
+    /**
+     * Tessellate again the given patches of pool (indices in the pool) after
+     * their control points moved, sending only their vertices.
+     */
+    void retessellate(const PatchPool& pool, const std::vector<GLuint>& patches);
+
+    /**
+     * Draw the patches, the program being bound: each one at the coarsest
+     * level whose segments span at most maxSegmentPixels on a viewport of
+     * viewportHeight pixels. Patches out of the frustum are skipped. The
+     * draw lists are built in arena.
+     */
+    void draw(const GLMat4& projection, const GLMat4& modelview,
+              GLint viewportHeight, float maxSegmentPixels, FrameArena& arena);
+
+    /**
+     * Size of the vertices in bytes.
+     */
+    inline std::size_t memory() const {
+        return vertexBytes;
+    }
+
+    /**
+     * Number of patches drawn at each level by the last draw.
+     */
+    inline const std::array<GLsizei, LEVELS.size()>& drawnCounts() const {
+        return drawn;
+    }
+
+private:
+    struct LodPatch {
+        GLVec3 center;
+        GLfloat radius;
+        GLint baseVertex;
+    };
+
+    void releaseVertices();
+
+    BufferPool& buffers;
+    // built for the buffer of the given pool revision
+    SP_VAO vao;
+    GLuint vaoRevision;
+    BufferPool::Range indexRange;
+    // one range per update
+    std::vector<BufferPool::Range> vertexRanges;
+    std::size_t vertexBytes;
+
+    std::vector<LodPatch> lodPatches;
+    // index in lodPatches of each patch of the pool, -1 if not tessellated
+    std::vector<GLint> slots;
+    std::uint64_t generation;
+    std::size_t tessellatedCount;
+
+    // in the EBO and in the vertex block of a patch
+    std::array<GLsizei, LEVELS.size()> indexCounts;
+    std::array<GLuint, LEVELS.size()> indexOffsets;
+    std::array<GLint, LEVELS.size()> vertexOffsets;
+    GLint patchVertices;
+
+    std::array<GLsizei, LEVELS.size()> drawn;
+};
+
+#endif //BEZIER_PATCH_LOD_HPP
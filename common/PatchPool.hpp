@@ -0,0 +1,112 @@
+#ifndef BEZIER_PATCH_POOL_HPP
+#define BEZIER_PATCH_POOL_HPP
+
+#include "ControlPoint.hpp"
+
+#include <cstdint>
+
+/**
+ * One Bezier curve segment (countV == 1) or rectangular patch stored in the
+ * pool. Its countU * countV control points start at first, the point
+ * (iu, iv) being at first + iu * countV + iv.
+ */
+struct PatchRecord {
+    GLuint first;
+    GLuint countU;
+    GLuint countV;
+
+    inline GLuint count() const { return countU * countV; }
+    inline bool isCurve() const { return countV == 1; }
+};
+
+/**
+ * Every Bezier segment/patch of a scene packed in one control point buffer.
+ * Not thread safe: producers running in parallel must serialize addPatch.
+ */
+class PatchPool {
+public:
+    PatchPool() :
+            resident(true),
+            replaceCount(0) {
+    }
+
+    inline ControlPointBuffer<>& controlPoints() { return cpBuffer; }
+    inline const ControlPointBuffer<>& controlPoints() const { return cpBuffer; }
+
+    inline const std::vector<PatchRecord>& patches() const { return records; }
+    inline std::size_t patchCount() const { return records.size(); }
+
+    inline void reserve(std::size_t patchCount, std::size_t pointCount) {
+        records.reserve(patchCount);
+        cpBuffer.points().reserve(pointCount);
+    }
+
+    /**
+     * False when the points only live on the GPU (see assign).
+     */
+    inline bool isResident() const { return resident; }
+
+    /**
+     * Changes when the patches are replaced (clear, assign), not when some
+     * are appended: what was built from the first patches is still valid if
+     * the generation did not change.
+     */
+    inline std::uint64_t generation() const { return replaceCount; }
+
+    inline void clear() {
+        records.clear();
+        cpBuffer.points().clear();
+        resident = true;
+        ++replaceCount;
+    }
+
+    /**
+     * Replace the content of the pool by external data (a mapped file for
+     * instance). The points are sent straight to the VBO; they are copied
+     * in memory only if keepCpuCopy is set, which is needed to edit them.
+     */
+    inline void assign(const PatchRecord* patches, std::size_t patchCount,
+                       const ControlPoint* points, std::size_t pointCount,
+                       bool keepCpuCopy) {
+        records.assign(patches, patches + patchCount);
+        if (keepCpuCopy) {
+            cpBuffer.points().assign(points, points + pointCount);
+            cpBuffer.upload();
+        } else {
+            cpBuffer.uploadFrom(points, pointCount);
+        }
+        resident = keepCpuCopy;
+        ++replaceCount;
+    }
+
+    /**
+     * Append a patch and return its index.
+     */
+    inline GLuint addPatch(const ControlPoint* points,
+                           GLuint countU, GLuint countV = 1) {
+        auto& cps = cpBuffer.points();
+        const auto first = static_cast<GLuint>(cps.size());
+        cps.insert(cps.end(), points, points + countU * countV);
+        records.push_back({first, countU, countV});
+        return static_cast<GLuint>(records.size() - 1);
+    }
+
+    inline void upload() {
+        cpBuffer.upload();
+    }
+
+    /**
+     * Send the points of the patches added since the last upload.
+     */
+    inline void uploadAppended() {
+        cpBuffer.uploadAppended();
+    }
+
+private:
+    ControlPointBuffer<> cpBuffer;
+    std::vector<PatchRecord> records;
+    bool resident;
+    std::uint64_t replaceCount;
+};
+
+#endif //BEZIER_PATCH_POOL_HPP
@@ -0,0 +1,77 @@
+#include "PatchStream.hpp"
+
+#include "NetImporter.hpp"
+
+#include "easycppogl_src/trace_profiler.h"
+
+#include <iostream>
+
+PatchStream::PatchStream() :
+        cancel(false),
+        finished(true) {
+}
+
+PatchStream::~PatchStream() {
+    stop();
+}
+
+void PatchStream::start(const std::string& path) {
+    stop();
+
+    cancel = false;
+    finished = false;
+    worker = std::thread([this, path]() {
+        TraceProfiler::set_thread_name("patch stream");
+        TraceZone zone("import control nets");
+        const BezierSink sink = [this](const ControlPoint* points,
+                                       GLuint countU, GLuint countV) {
+            push(points, countU, countV);
+        };
+        if (!importControlNets(path, sink, &cancel)) {
+            std::cerr << "Unable to import '" << path << "'" << std::endl;
+        }
+        finished = true;
+    });
+}
+
+void PatchStream::stop() {
+    if (worker.joinable()) {
+        cancel = true;
+        worker.join();
+    }
+    finished = true;
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pendingPoints.clear();
+    pendingPatches.clear();
+}
+
+void PatchStream::push(const ControlPoint* points,
+                       GLuint countU, GLuint countV) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    const auto first = static_cast<GLuint>(pendingPoints.size());
+    pendingPoints.insert(pendingPoints.end(), points, points + countU * countV);
+    pendingPatches.push_back({first, countU, countV});
+}
+
+std::size_t PatchStream::drain(PatchPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (pendingPatches.empty()) {
+            return 0;
+        }
+        std::swap(pendingPoints, drainedPoints);
+        std::swap(pendingPatches, drainedPatches);
+    }
+
+    for (const auto& patch : drainedPatches) {
+        pool.addPatch(drainedPoints.data() + patch.first,
+                      patch.countU, patch.countV);
+    }
+    pool.uploadAppended();
+
+    const std::size_t added = drainedPatches.size();
+    drainedPoints.clear();
+    drainedPatches.clear();
+    return added;
+}
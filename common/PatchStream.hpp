@@ -0,0 +1,58 @@
+#ifndef BEZIER_PATCH_STREAM_HPP
+#define BEZIER_PATCH_STREAM_HPP
+
+#include "PatchPool.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Imports a text control net file on a worker thread. The patches parsed so
+ * far are moved to the pool by drain, called from the GL thread once per
+ * frame, so the geometry shows up while the file is still being read.
+ */
+class PatchStream {
+public:
+    PatchStream();
+    ~PatchStream();
+
+    PatchStream(const PatchStream&) = delete;
+    PatchStream& operator=(const PatchStream&) = delete;
+
+    /**
+     * Stop the current import (if any) and start reading path.
+     */
+    void start(const std::string& path);
+
+    /**
+     * Stop the current import, the patches not drained yet are dropped.
+     */
+    void stop();
+
+    /**
+     * Append the pending patches to pool and upload their points, returns
+     * the number of patches added.
+     */
+    std::size_t drain(PatchPool& pool);
+
+    inline bool running() const { return !finished; }
+
+private:
+    void push(const ControlPoint* points, GLuint countU, GLuint countV);
+
+    std::thread worker;
+    std::atomic<bool> cancel;
+    std::atomic<bool> finished;
+
+    std::mutex pendingMutex;
+    std::vector<ControlPoint> pendingPoints;
+    std::vector<PatchRecord> pendingPatches;
+
+    // swapped with the pending ones by drain, keeps their capacity
+    std::vector<ControlPoint> drainedPoints;
+    std::vector<PatchRecord> drainedPatches;
+};
+
+#endif //BEZIER_PATCH_STREAM_HPP
@@ -0,0 +1,52 @@
+#include "RandomNet.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+void generateRandomNet(PatchPool& pool, std::size_t patchCount,
+                       unsigned seed, GLuint degree, float size) {
+    if (patchCount == 0 || degree == 0) {
+        return;
+    }
+
+    const auto columns = static_cast<std::size_t>(
+            std::ceil(std::sqrt(static_cast<double>(patchCount)))
+    );
+    const std::size_t rows = (patchCount + columns - 1) / columns;
+    const std::size_t gridU = columns * degree + 1;
+    const std::size_t gridV = rows * degree + 1;
+
+    const float offset = size / static_cast<float>(gridU - 1);
+    const float uHalfSize = size / 2.f;
+    const float vHalfSize = offset * static_cast<float>(gridV - 1) / 2.f;
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(0.f, 2.f * offset);
+
+    std::vector<ControlPoint> grid;
+    grid.reserve(gridU * gridV);
+    for (std::size_t u = 0; u < gridU; ++u) {
+        for (std::size_t v = 0; v < gridV; ++v) {
+            grid.emplace_back(static_cast<float>(u) * offset - uHalfSize,
+                              static_cast<float>(v) * offset - vHalfSize,
+                              distribution(generator));
+        }
+    }
+
+    const GLuint count = degree + 1;
+    pool.reserve(pool.patchCount() + patchCount,
+                 pool.controlPoints().points().size() + patchCount * count * count);
+
+    std::vector<ControlPoint> points(count * count);
+    for (std::size_t p = 0; p < patchCount; ++p) {
+        const std::size_t firstU = (p % columns) * degree;
+        const std::size_t firstV = (p / columns) * degree;
+        for (GLuint iu = 0; iu < count; ++iu) {
+            for (GLuint iv = 0; iv < count; ++iv) {
+                points[iu * count + iv] = grid[(firstU + iu) * gridV + firstV + iv];
+            }
+        }
+        pool.addPatch(points.data(), count, count);
+    }
+}
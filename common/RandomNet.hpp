@@ -0,0 +1,17 @@
+#ifndef BEZIER_RANDOM_NET_HPP
+#define BEZIER_RANDOM_NET_HPP
+
+#include "PatchPool.hpp"
+
+/**
+ * Append patchCount patches of the given degree forming one random height
+ * field, the first demo surface scaled up: a regular grid of control points
+ * in the xy plane, size wide and centered on the origin, their heights
+ * uniform in [0, 2] grid steps. The patches are laid out row by row in a
+ * square and share their border points, so the surface is continuous.
+ * The same seed always gives the same net.
+ */
+void generateRandomNet(PatchPool& pool, std::size_t patchCount,
+                       unsigned seed = 0, GLuint degree = 3, float size = 4.f);
+
+#endif //BEZIER_RANDOM_NET_HPP
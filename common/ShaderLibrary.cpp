@@ -0,0 +1,225 @@
+#include "ShaderLibrary.hpp"
+
+#include "FileWatcher.hpp"
+#include "utils.hpp"
+
+#include "easycppogl_src/trace_profiler.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+namespace {
+    // how often the worker checks whether it must stop
+    constexpr int WATCH_TIMEOUT_MS = 200;
+
+    bool usesAny(const std::vector<ShaderStage>& stages,
+                 const std::vector<std::string>& paths) {
+        return std::any_of(stages.begin(), stages.end(),
+                           [&paths](const ShaderStage& stage) {
+                               return std::find(paths.begin(), paths.end(), stage.path)
+                                      != paths.end();
+                           });
+    }
+}
+
+ShaderLibrary::ShaderLibrary() :
+        context(nullptr),
+        stopping(false) {
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    shutdown();
+}
+
+void ShaderLibrary::shutdown() {
+    if (worker.joinable()) {
+        stopping = true;
+        worker.join();
+        stopping = false;
+    }
+    if (context) {
+        glfwDestroyWindow(context);
+        context = nullptr;
+    }
+    watcher.reset();
+
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    entries.clear();
+}
+
+SP_ShaderProgram ShaderLibrary::create(const std::vector<ShaderStage>& stages,
+                                       const std::string& name,
+                                       const std::vector<std::string>& defines) {
+    SP_ShaderProgram program(build(stages, name, defines));
+    if (!program) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    entries.push_back({program, stages, name, defines});
+    if (watcher) {
+        for (const auto& stage : stages) {
+            watcher->add(stage.path);
+        }
+    }
+    return program;
+}
+
+bool ShaderLibrary::enableHotReload(const std::string& directory,
+                                    GLFWwindow* context) {
+    if (directory.empty() || !context || worker.joinable()) {
+        return false;
+    }
+    this->context = context;
+
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        watcher.reset(new FileWatcher(directory));
+        for (const auto& entry : entries) {
+            for (const auto& stage : entry.stages) {
+                watcher->add(stage.path);
+            }
+        }
+    }
+
+    worker = std::thread([this]() {
+        TraceProfiler::set_thread_name("shader reload");
+        glfwMakeContextCurrent(this->context);
+        while (!stopping) {
+            const auto changed = watcher->wait(WATCH_TIMEOUT_MS);
+            if (!changed.empty()) {
+                reload(changed);
+            }
+        }
+
+        // the versions never installed are deleted while a context is current
+        {
+            std::lock_guard<std::mutex> lock(rebuiltMutex);
+            for (auto& version : rebuilt) {
+                glDeleteSync(version.fence);
+            }
+            rebuilt.clear();
+        }
+        glfwMakeContextCurrent(nullptr);
+    });
+    std::cout << "Hot reloading the shaders of '" << directory << "'" << std::endl;
+    return true;
+}
+
+std::size_t ShaderLibrary::update() {
+    std::size_t installed = 0;
+
+    std::lock_guard<std::mutex> lock(rebuiltMutex);
+    auto version = rebuilt.begin();
+    for (; version != rebuilt.end(); ++version) {
+        // fences of one context signal in order, the next ones are not ready
+        const GLenum status = glClientWaitSync(version->fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        glDeleteSync(version->fence);
+
+        auto target = version->target.lock();
+        if (target && status != GL_WAIT_FAILED) {
+            target->swap(*version->program);
+            ++installed;
+        }
+    }
+    // deletes the previous versions, now held by the rebuilt programs
+    rebuilt.erase(rebuilt.begin(), version);
+
+    return installed;
+}
+
+void ShaderLibrary::reload(const std::vector<std::string>& changed) {
+    std::vector<Entry> stale;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        for (const auto& entry : entries) {
+            if (!entry.program.expired() && usesAny(entry.stages, changed)) {
+                stale.push_back(entry);
+            }
+        }
+    }
+
+    for (const auto& entry : stale) {
+        TraceZone zone("rebuild shader");
+        std::cout << "Reloading shader program " << entry.name << std::endl;
+        auto program = build(entry.stages, entry.name, entry.defines);
+        if (!program) {
+            std::cerr << "Keeping the previous version of " << entry.name
+                      << std::endl;
+            continue;
+        }
+
+        // the main context sees the linked program once this fence signaled
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(rebuiltMutex);
+        rebuilt.push_back({entry.program, std::move(program), fence});
+    }
+}
+
+std::unique_ptr<ShaderProgram> ShaderLibrary::build(const std::vector<ShaderStage>& stages,
+                                                    const std::string& name,
+                                                    const std::vector<std::string>& defines) {
+    std::vector<std::string> sources;
+    sources.reserve(stages.size());
+    for (const auto& stage : stages) {
+        sources.push_back(ShaderProgram::specialize(readFile(stage.path), defines));
+    }
+
+    std::vector<std::pair<GLenum, const std::string&>> program;
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        program.emplace_back(stages[i].type, sources[i]);
+    }
+
+    std::unique_ptr<ShaderProgram> result(new ShaderProgram(program, name));
+    GLint status = GL_FALSE;
+    glGetProgramiv(result->id(), GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::cerr << "Error in compiling ShaderProgram " << name << std::endl;
+        return nullptr;
+    }
+    return result;
+}
+
+ShaderVariants::ShaderVariants(std::vector<ShaderStage> stages, std::string name,
+                               DefinesOf definesOf) :
+        library(nullptr),
+        stages(std::move(stages)),
+        name(std::move(name)),
+        definesOf(std::move(definesOf)) {
+}
+
+const SP_ShaderProgram& ShaderVariants::init(ShaderLibrary& library) {
+    this->library = &library;
+    variants.clear();
+    genericProgram = library.create(stages, name);
+    return genericProgram;
+}
+
+void ShaderVariants::release() {
+    variants.clear();
+    genericProgram.reset();
+}
+
+const SP_ShaderProgram& ShaderVariants::get(GLuint key) {
+    auto variant = variants.find(key);
+    if (variant == variants.end()) {
+        const auto defines = definesOf(key);
+        std::string variantName = name;
+        for (const auto& define : defines) {
+            variantName += " [" + define + "]";
+        }
+
+        SP_ShaderProgram program;
+        if (library && !defines.empty()) {
+            program = library->create(stages, variantName, defines);
+        }
+        variant = variants.emplace(key, program ? program : genericProgram).first;
+    }
+    return variant->second;
+}
@@ -0,0 +1,143 @@
+#ifndef BEZIER_SHADER_LIBRARY_HPP
+#define BEZIER_SHADER_LIBRARY_HPP
+
+#include "easycppogl_src/shader_program.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace EZCOGL;
+
+struct GLFWwindow;
+class FileWatcher;
+
+struct ShaderStage {
+    GLenum type;
+    // relative to resources/, read with readFile
+    std::string path;
+};
+
+/**
+ * Creates the shader programs from the resources and, once hot reload is
+ * enabled, rebuilds them when their sources change.
+ *
+ * Rebuilds run on a worker thread owning a context shared with the viewer
+ * one: a new version is compiled and linked there, then fenced. update,
+ * called by the GL thread once per frame, swaps the programs whose fence
+ * has signaled into the SP_ShaderProgram returned by create, without ever
+ * waiting. A version which does not compile is reported and the previous
+ * one kept.
+ */
+class ShaderLibrary {
+public:
+    ShaderLibrary();
+    ~ShaderLibrary();
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    /**
+     * Program linked from the stages, empty if it does not link. The defines
+     * ("NAME value" each) are inserted in every stage.
+     */
+    SP_ShaderProgram create(const std::vector<ShaderStage>& stages,
+                            const std::string& name = "",
+                            const std::vector<std::string>& defines = {});
+
+    /**
+     * Watch the sources of the programs below directory (the one readFile
+     * reads from) and rebuild them with context, an invisible window sharing
+     * the viewer context (see GLViewer::create_shared_context), destroyed
+     * with the library. To be called from the main thread.
+     */
+    bool enableHotReload(const std::string& directory, GLFWwindow* context);
+
+    /**
+     * Install the rebuilt programs which are ready, returns their number.
+     * To be called from the GL thread.
+     */
+    std::size_t update();
+
+    /**
+     * Stop hot reloading, destroy its context and forget the programs. To be
+     * called from the main thread while the viewer context still exists.
+     */
+    void shutdown();
+
+private:
+    struct Entry {
+        std::weak_ptr<ShaderProgram> program;
+        std::vector<ShaderStage> stages;
+        std::string name;
+        std::vector<std::string> defines;
+    };
+
+    struct Rebuilt {
+        std::weak_ptr<ShaderProgram> target;
+        std::unique_ptr<ShaderProgram> program;
+        GLsync fence;
+    };
+
+    void reload(const std::vector<std::string>& changed);
+
+    static std::unique_ptr<ShaderProgram> build(const std::vector<ShaderStage>& stages,
+                                                const std::string& name,
+                                                const std::vector<std::string>& defines);
+
+    std::mutex entriesMutex;
+    std::vector<Entry> entries;
+
+    std::mutex rebuiltMutex;
+    std::vector<Rebuilt> rebuilt;
+
+    std::unique_ptr<FileWatcher> watcher;
+    GLFWwindow* context;
+    std::thread worker;
+    std::atomic<bool> stopping;
+};
+
+/**
+ * Variants of a program specialized on compile time constants, e.g. one per
+ * patch size so the evaluation loops of the shaders are unrolled. A variant
+ * is built the first time its key is asked for, with the defines given by
+ * definesOf(key), then cached; keys without a working variant get the
+ * generic program, built without defines.
+ */
+class ShaderVariants {
+public:
+    using DefinesOf = std::function<std::vector<std::string>(GLuint key)>;
+
+    ShaderVariants(std::vector<ShaderStage> stages, std::string name,
+                   DefinesOf definesOf);
+
+    /**
+     * Build the generic program, returns it.
+     */
+    const SP_ShaderProgram& init(ShaderLibrary& library);
+
+    const SP_ShaderProgram& get(GLuint key);
+
+    inline const SP_ShaderProgram& generic() const { return genericProgram; }
+
+    /**
+     * Drop the programs, while the context still exists.
+     */
+    void release();
+
+private:
+    ShaderLibrary* library;
+    std::vector<ShaderStage> stages;
+    std::string name;
+    DefinesOf definesOf;
+
+    SP_ShaderProgram genericProgram;
+    std::unordered_map<GLuint, SP_ShaderProgram> variants;
+};
+
+#endif //BEZIER_SHADER_LIBRARY_HPP
@@ -0,0 +1,144 @@
+#include "TessLevels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    bool lexicographicLess(const GLVec4& a, const GLVec4& b) {
+        for (int i = 0; i < 4; ++i) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i];
+            }
+        }
+        return false;
+    }
+}
+
+std::string to_string(TessSpacing spacing) {
+    switch (spacing) {
+        case TessSpacing::Equal:
+            return "Equal";
+        case TessSpacing::FractionalEven:
+            return "Fractional even";
+        case TessSpacing::FractionalOdd:
+            return "Fractional odd";
+        default:
+            return "Unknown";
+    }
+}
+
+std::string spacingQualifier(TessSpacing spacing) {
+    switch (spacing) {
+        case TessSpacing::FractionalEven:
+            return "fractional_even_spacing";
+        case TessSpacing::FractionalOdd:
+            return "fractional_odd_spacing";
+        default:
+            return "equal_spacing";
+    }
+}
+
+void edgeParameters(float level, TessSpacing spacing, std::vector<float>& parameters) {
+    parameters.clear();
+    if (spacing == TessSpacing::Equal) {
+        const float n = std::ceil(std::min(std::max(level, 1.f), MAX_TESS_LEVEL));
+        for (float k = 0.f; k <= n; ++k) {
+            parameters.push_back(k / n);
+        }
+        return;
+    }
+
+    // the level rounded up to an odd or even segment count n: n - 2 segments
+    // of length 1 / level and two shorter ones making up the rest
+    const bool odd = spacing == TessSpacing::FractionalOdd;
+    const float f = odd ? std::min(std::max(level, 1.f), MAX_TESS_LEVEL - 1.f)
+                        : std::min(std::max(level, 2.f), MAX_TESS_LEVEL);
+    const int n = odd ? 2 * static_cast<int>(std::ceil((f - 1.f) / 2.f)) + 1
+                      : 2 * static_cast<int>(std::ceil(f / 2.f));
+    if (static_cast<float>(n) == f) {
+        edgeParameters(f, TessSpacing::Equal, parameters);
+        return;
+    }
+    const float full = 1.f / f;
+    const float reduced = (1.f - static_cast<float>(n - 2) * full) / 2.f;
+
+    // odd: full ones, a short one, the middle full one, a short one, full ones
+    std::vector<float> lengths(static_cast<std::size_t>(n), full);
+    const int side = odd ? (n - 3) / 2 : (n - 2) / 2;
+    lengths[side] = reduced;
+    lengths[n - 1 - side] = reduced;
+
+    // the second half mirrors the first one, so the same from both ends
+    parameters.resize(static_cast<std::size_t>(n) + 1);
+    parameters[0] = 0.f;
+    for (int k = 1; 2 * k <= n; ++k) {
+        parameters[k] = parameters[k - 1] + lengths[k - 1];
+    }
+    for (int k = n / 2 + 1; k <= n; ++k) {
+        parameters[k] = 1.f - parameters[n - k];
+    }
+}
+
+PatchEdge patchEdge(const PatchRecord& patch, GLuint edge) {
+    switch (edge) {
+        case 0:
+            return {patch.first, 1, patch.countV};
+        case 1:
+            return {patch.first, patch.countV, patch.countU};
+        case 2:
+            return {patch.first + (patch.countU - 1) * patch.countV, 1, patch.countV};
+        default:
+            return {patch.first + patch.countV - 1, patch.countV, patch.countU};
+    }
+}
+
+bool reversedEdge(const std::vector<ControlPoint>& points, const PatchEdge& edge) {
+    const GLuint last = edge.first + (edge.count - 1) * edge.stride;
+    for (GLuint k = 0; k < edge.count / 2; ++k) {
+        const GLVec4 a = points[edge.first + k * edge.stride].homogeneous();
+        const GLVec4 b = points[last - k * edge.stride].homogeneous();
+        if (a != b) {
+            return lexicographicLess(b, a);
+        }
+    }
+    return false;
+}
+
+float edgeLevel(const std::vector<ControlPoint>& points, const PatchEdge& edge,
+                const TessLevelParams& params) {
+    if (!params.adaptive) {
+        return std::min(std::max(params.level, 1.f), MAX_TESS_LEVEL);
+    }
+
+    const bool reversed = reversedEdge(points, edge);
+    const GLuint last = edge.first + (edge.count - 1) * edge.stride;
+
+    // length of the projected control polygon, which bounds the curve one
+    float length = 0.f;
+    GLVec2 previous;
+    for (GLuint k = 0; k < edge.count; ++k) {
+        const GLuint index = reversed ? last - k * edge.stride
+                                      : edge.first + k * edge.stride;
+        const GLVec4 clip = params.mvp * points[index].homogeneous();
+        if (clip.w() <= 0.f) {
+            return MAX_TESS_LEVEL;
+        }
+        const GLVec2 window = (clip.head<2>() / clip.w() * 0.5f)
+                .cwiseProduct(params.viewport);
+        if (k > 0) {
+            length += (window - previous).norm();
+        }
+        previous = window;
+    }
+    return std::min(std::max(length / params.segmentPixels, 1.f), MAX_TESS_LEVEL);
+}
+
+std::array<float, 4> outerLevels(const std::vector<ControlPoint>& points,
+                                 const PatchRecord& patch,
+                                 const TessLevelParams& params) {
+    std::array<float, 4> levels;
+    for (GLuint edge = 0; edge < 4; ++edge) {
+        levels[edge] = edgeLevel(points, patchEdge(patch, edge), params);
+    }
+    return levels;
+}
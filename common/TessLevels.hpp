@@ -0,0 +1,93 @@
+#ifndef BEZIER_TESS_LEVELS_HPP
+#define BEZIER_TESS_LEVELS_HPP
+
+#include "PatchPool.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+// GL_MAX_TESS_GEN_LEVEL is at least 64
+constexpr float MAX_TESS_LEVEL = 64.f;
+
+/**
+ * Spacing of the vertices along the edges, the layout qualifier of the
+ * evaluation shaders. With the fractional ones, the vertices move
+ * continuously with the level instead of popping at each integer.
+ */
+enum class TessSpacing {
+    Equal = 0,
+    FractionalEven = 1,
+    FractionalOdd = 2
+};
+
+std::string to_string(TessSpacing spacing);
+
+/**
+ * GLSL name of the spacing, e.g. fractional_odd_spacing.
+ */
+std::string spacingQualifier(TessSpacing spacing);
+
+/**
+ * Parameters in [0, 1] of the vertices of an edge tessellated at level.
+ * The fractional spacings have two shorter segments; where they go is left
+ * to the implementation, they are put next to the middle of the edge as
+ * most hardware does. Symmetric, so the same from both ends.
+ */
+void edgeParameters(float level, TessSpacing spacing, std::vector<float>& parameters);
+
+/**
+ * What the tessellation levels of the rectangular patches depend on, the
+ * uniforms of bezier_surface_rect/tessCont.glsl.
+ */
+struct TessLevelParams {
+    // every edge level when not adaptive (uLevel)
+    float level;
+    bool adaptive;
+    GLMat4 mvp;
+    // uViewport
+    GLVec2 viewport;
+    // on screen length of a segment of an adaptive edge (uSegmentPixels)
+    float segmentPixels;
+    TessSpacing spacing;
+};
+
+/**
+ * Control points of an edge of a patch: count points from first, every
+ * stride.
+ */
+struct PatchEdge {
+    GLuint first;
+    GLuint stride;
+    GLuint count;
+};
+
+/**
+ * Edge of a patch in the order of gl_TessLevelOuter: u = 0, v = 0, u = 1,
+ * v = 1. Its points go in increasing u or v.
+ */
+PatchEdge patchEdge(const PatchRecord& patch, GLuint edge);
+
+/**
+ * Whether the points of an edge are read backwards in the canonical order,
+ * which starts from the smaller end (comparing the homogeneous points
+ * lexicographically). Two patches sharing an edge see the same sequence.
+ */
+bool reversedEdge(const std::vector<ControlPoint>& points, const PatchEdge& edge);
+
+/**
+ * Level of an edge, the CPU version of edgeLevel in tessCont.glsl: a pure
+ * function of the edge control points read in the canonical order, so the
+ * two patches sharing the edge agree on it.
+ */
+float edgeLevel(const std::vector<ControlPoint>& points, const PatchEdge& edge,
+                const TessLevelParams& params);
+
+/**
+ * gl_TessLevelOuter of a patch.
+ */
+std::array<float, 4> outerLevels(const std::vector<ControlPoint>& points,
+                                 const PatchRecord& patch,
+                                 const TessLevelParams& params);
+
+#endif //BEZIER_TESS_LEVELS_HPP
@@ -0,0 +1,267 @@
+#include "TextReader.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+ChunkedLineReader::ChunkedLineReader(bool joinContinuations,
+                                     std::size_t chunkSize) :
+        file(nullptr),
+        joinContinuations(joinContinuations),
+        buffer(chunkSize),
+        begin(0),
+        end(0),
+        consumed(0),
+        totalSize(0),
+        eof(true) {
+}
+
+ChunkedLineReader::~ChunkedLineReader() {
+    close();
+}
+
+bool ChunkedLineReader::open(const std::string& path) {
+    close();
+
+    file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        std::cerr << "Unable to open file '" << path << "'" << std::endl;
+        return false;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    const long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    totalSize = length > 0 ? static_cast<std::size_t>(length) : 0;
+
+    begin = end = consumed = 0;
+    eof = false;
+    return true;
+}
+
+void ChunkedLineReader::close() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+    file = nullptr;
+    eof = true;
+}
+
+bool ChunkedLineReader::refill() {
+    if (eof) {
+        return false;
+    }
+
+    // keep the unfinished line at the front, grow only for huge lines
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    const std::size_t n = std::fread(buffer.data() + end, 1,
+                                     buffer.size() - end, file);
+    end += n;
+    if (n == 0) {
+        eof = true;
+    }
+    return n > 0;
+}
+
+bool ChunkedLineReader::nextLine(TextSpan& line) {
+    std::size_t scan = begin;
+    for (;;) {
+        char* data = buffer.data();
+        const auto* nl = static_cast<char*>(
+                std::memchr(data + scan, '\n', end - scan)
+        );
+
+        if (nl == nullptr) {
+            const std::size_t scanOffset = scan - begin;
+            if (refill()) {
+                scan = begin + scanOffset;
+                continue;
+            }
+            if (begin == end) {
+                return false;
+            }
+            // refill may have moved or grown the buffer
+            data = buffer.data();
+
+            // last line without end of line
+            std::size_t last = end;
+            if (data[last - 1] == '\r') {
+                --last;
+            }
+            line = {data + begin, data + last};
+            consumed += end - begin;
+            begin = end;
+            return true;
+        }
+
+        const std::size_t newline = static_cast<std::size_t>(nl - data);
+        std::size_t last = newline;
+        if (last > begin && data[last - 1] == '\r') {
+            --last;
+        }
+
+        if (joinContinuations && last > begin && data[last - 1] == '\\') {
+            // blank the backslash and end of line, the statement goes on
+            std::memset(data + last - 1, ' ', newline - last + 2);
+            scan = newline + 1;
+            continue;
+        }
+
+        line = {data + begin, data + last};
+        consumed += newline + 1 - begin;
+        begin = newline + 1;
+        return true;
+    }
+}
+
+
+namespace {
+
+constexpr double exactPowers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool slowParseDouble(const TextSpan& token, double& value) {
+    char local[64];
+    if (token.size() >= sizeof(local)) {
+        return false;
+    }
+    std::memcpy(local, token.begin, token.size());
+    local[token.size()] = '\0';
+
+    char* last = nullptr;
+    value = std::strtod(local, &last);
+    return last == local + token.size();
+}
+
+} // namespace
+
+bool parseDouble(const TextSpan& token, double& value) {
+    const char* p = token.begin;
+    const char* const end = token.end;
+    if (p == end) {
+        return false;
+    }
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        ++p;
+    }
+
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            if (mantissa != 0) {
+                ++digits;
+            }
+        } else {
+            ++exponent;
+        }
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                if (mantissa != 0) {
+                    ++digits;
+                }
+                --exponent;
+            }
+        }
+    }
+    if (!any) {
+        return slowParseDouble(token, value);
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')) {
+        ++p;
+        bool negativeExp = false;
+        if (p != end && (*p == '+' || *p == '-')) {
+            negativeExp = *p == '-';
+            ++p;
+        }
+        if (p == end) {
+            return false;
+        }
+        int e = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            if (e < 100000) {
+                e = e * 10 + (*p - '0');
+            }
+        }
+        exponent += negativeExp ? -e : e;
+    }
+    if (p != end) {
+        return false;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa == 0) {
+        result = 0.;
+    } else if (mantissa < (std::uint64_t(1) << 53) && exponent >= -22
+               && exponent <= 22) {
+        // both operands are exact, a single rounding
+        result = exponent < 0 ? result / exactPowers[-exponent]
+                              : result * exactPowers[exponent];
+    } else {
+        result *= std::pow(10., exponent);
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+bool parseFloat(const TextSpan& token, float& value) {
+    double d;
+    if (!parseDouble(token, d)) {
+        return false;
+    }
+    value = static_cast<float>(d);
+    return true;
+}
+
+bool parseLong(const TextSpan& token, long& value) {
+    const char* p = token.begin;
+    if (p == token.end) {
+        return false;
+    }
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == token.end) {
+        return false;
+    }
+
+    long result = 0;
+    for (; p != token.end; ++p) {
+        if (*p < '0' || *p > '9'
+            || result > (std::numeric_limits<long>::max() - 9) / 10) {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef BEZIER_TEXT_READER_HPP
+#define BEZIER_TEXT_READER_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Characters [begin, end) of a buffer owned by someone else.
+ */
+struct TextSpan {
+    const char* begin;
+    const char* end;
+
+    inline bool empty() const { return begin == end; }
+    inline std::size_t size() const { return static_cast<std::size_t>(end - begin); }
+
+    inline bool operator==(const char* str) const {
+        const std::size_t length = std::strlen(str);
+        return size() == length && std::memcmp(begin, str, length) == 0;
+    }
+    inline bool operator!=(const char* str) const { return !(*this == str); }
+
+    inline std::string str() const { return std::string(begin, end); }
+};
+
+/**
+ * Reads a text file by large chunks and hands out its lines without copying
+ * them: a line is only valid until the next call to nextLine. When
+ * joinContinuations is set, a line ending with a backslash is merged with
+ * the next one (OBJ statements spanning several lines).
+ */
+class ChunkedLineReader {
+public:
+    explicit ChunkedLineReader(bool joinContinuations = false,
+                               std::size_t chunkSize = 1u << 20);
+    ~ChunkedLineReader();
+
+    ChunkedLineReader(const ChunkedLineReader&) = delete;
+    ChunkedLineReader& operator=(const ChunkedLineReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * Next line without its end of line, false at the end of the file.
+     */
+    bool nextLine(TextSpan& line);
+
+    /**
+     * Bytes consumed so far and file size, for progress reports.
+     */
+    inline std::size_t bytesRead() const { return consumed; }
+    inline std::size_t fileSize() const { return totalSize; }
+
+private:
+    bool refill();
+
+    std::FILE* file;
+    bool joinContinuations;
+    std::vector<char> buffer;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t consumed;
+    std::size_t totalSize;
+    bool eof;
+};
+
+/**
+ * Split the next token off line (separators are spaces and tabs), false if
+ * there is none left.
+ */
+inline bool nextToken(TextSpan& line, TextSpan& token) {
+    const char* p = line.begin;
+    while (p != line.end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    if (p == line.end) {
+        line.begin = p;
+        return false;
+    }
+    token.begin = p;
+    while (p != line.end && *p != ' ' && *p != '\t') {
+        ++p;
+    }
+    token.end = p;
+    line.begin = p;
+    return true;
+}
+
+/**
+ * Decimal number [+-]digits[.digits][(e|E|d|D)[+-]digits], the whole token
+ * must be consumed. The first 19 significant digits are accumulated in an
+ * integer and scaled once by a power of ten: exact for the usual short
+ * inputs, within a few ulps otherwise. Other spellings (inf, nan, hex
+ * floats) go through strtod.
+ */
+bool parseDouble(const TextSpan& token, double& value);
+
+bool parseFloat(const TextSpan& token, float& value);
+
+bool parseLong(const TextSpan& token, long& value);
+
+#endif //BEZIER_TEXT_READER_HPP
@@ -0,0 +1,89 @@
+#ifndef BEZIER_VERTEX_FORMAT_HPP
+#define BEZIER_VERTEX_FORMAT_HPP
+
+#include "easycppogl_src/vao.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Memory layout of the vertices inside a VBO.
+ *  - Interleaved: AoS, all the attributes of a vertex side by side.
+ *  - Blocks: SoA, one contiguous block per attribute.
+ */
+enum class VertexLayout {
+    Interleaved,
+    Blocks
+};
+
+constexpr std::size_t glTypeSize(GLenum type) {
+    return (type == GL_BYTE || type == GL_UNSIGNED_BYTE) ? 1
+         : (type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_HALF_FLOAT) ? 2
+         : (type == GL_DOUBLE) ? 8
+         : 4;
+}
+
+/**
+ * Compile-time description of one vertex attribute.
+ */
+template <GLint Location, GLint Size, GLenum Type = GL_FLOAT, bool Normalized = false>
+struct Attribute {
+    static constexpr GLint location = Location;
+    static constexpr GLint size = Size;
+    static constexpr GLenum type = Type;
+    static constexpr bool normalized = Normalized;
+    static constexpr std::size_t bytes = Size * glTypeSize(Type);
+};
+
+/**
+ * Compile-time vertex format: the attributes are listed in the order they
+ * are stored in the CPU-side vertex structure.
+ */
+template <typename... Attributes>
+struct VertexFormat;
+
+template <>
+struct VertexFormat<> {
+    static constexpr std::size_t stride = 0;
+    static constexpr std::size_t count = 0;
+
+    static void describe(std::vector<EZCOGL::VertexAttribute>&, VertexLayout,
+                         GLuint, std::size_t, std::size_t) {}
+};
+
+template <typename First, typename... Others>
+struct VertexFormat<First, Others...> {
+    static constexpr std::size_t stride = First::bytes + VertexFormat<Others...>::stride;
+    static constexpr std::size_t count = 1 + sizeof...(Others);
+
+    /**
+     * Attributes ready to be given to VAO::create for a buffer of
+     * vertexCount vertices stored with the given layout.
+     */
+    static std::vector<EZCOGL::VertexAttribute> attributes(VertexLayout layout,
+                                                           GLuint vertexCount) {
+        std::vector<EZCOGL::VertexAttribute> atts;
+        atts.reserve(count);
+        describe(atts, layout, vertexCount, 0, stride);
+        return atts;
+    }
+
+    static void describe(std::vector<EZCOGL::VertexAttribute>& atts,
+                         VertexLayout layout, GLuint vertexCount,
+                         std::size_t vertexOffset, std::size_t vertexStride) {
+        const bool interleaved = layout == VertexLayout::Interleaved;
+        atts.push_back({
+            First::location,
+            First::size,
+            First::type,
+            First::normalized ? GLboolean(GL_TRUE) : GLboolean(GL_FALSE),
+            GLsizei(interleaved ? vertexStride : First::bytes),
+            GLuint(interleaved ? vertexOffset : vertexOffset * vertexCount)
+        });
+        VertexFormat<Others...>::describe(atts, layout, vertexCount,
+                                          vertexOffset + First::bytes,
+                                          vertexStride);
+    }
+};
+
+#endif //BEZIER_VERTEX_FORMAT_HPP
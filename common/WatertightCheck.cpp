@@ -0,0 +1,158 @@
+#include "WatertightCheck.hpp"
+
+#include "Bezier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+
+namespace {
+    using HPoints = std::vector<Homogeneous<float>,
+                                Eigen::aligned_allocator<Homogeneous<float>>>;
+    using Points = std::vector<Point3<float>>;
+
+    struct EdgeSide {
+        GLuint patch;
+        GLuint edge;
+        GLuint segments;
+        // in the canonical order of the edge
+        Points vertices;
+    };
+
+    /**
+     * Vertices of an edge at the given parameters, evaluated on the patch
+     * like the evaluation shader does.
+     */
+    void edgeVertices(const HPoints& controlPoints, const PatchRecord& patch,
+                      GLuint edge, const std::vector<float>& parameters,
+                      Points& vertices) {
+        vertices.resize(parameters.size());
+        for (std::size_t k = 0; k < parameters.size(); ++k) {
+            const float t = parameters[k];
+            const float u = edge == 0 ? 0.f : edge == 2 ? 1.f : t;
+            const float v = edge == 1 ? 0.f : edge == 3 ? 1.f : t;
+            vertices[k] = fromHomogeneous(evaluatePatch(controlPoints.data(),
+                                                        patch.countU, patch.countV,
+                                                        u, v));
+        }
+    }
+
+    float segmentDistance(const Point3<float>& p, const Point3<float>& a,
+                          const Point3<float>& b) {
+        const Point3<float> ab = b - a;
+        const float squared = ab.squaredNorm();
+        const float t = squared > 0.f
+                        ? std::min(std::max((p - a).dot(ab) / squared, 0.f), 1.f)
+                        : 0.f;
+        return (a + t * ab - p).norm();
+    }
+
+    /**
+     * Largest distance from a vertex of from to the polyline through to.
+     */
+    float polylineGap(const Points& from, const Points& to) {
+        float gap = 0.f;
+        for (const auto& p : from) {
+            float closest = std::numeric_limits<float>::max();
+            for (std::size_t i = 0; i + 1 < to.size(); ++i) {
+                closest = std::min(closest, segmentDistance(p, to[i], to[i + 1]));
+            }
+            gap = std::max(gap, closest);
+        }
+        return gap;
+    }
+
+    float gapBetween(const EdgeSide& a, const EdgeSide& b) {
+        if (a.segments != b.segments) {
+            return std::max(polylineGap(a.vertices, b.vertices),
+                            polylineGap(b.vertices, a.vertices));
+        }
+        float gap = 0.f;
+        for (std::size_t k = 0; k < a.vertices.size(); ++k) {
+            gap = std::max(gap, (a.vertices[k] - b.vertices[k]).norm());
+        }
+        return gap;
+    }
+}
+
+bool checkWatertight(const PatchPool& pool, const TessLevelParams& params,
+                     WatertightReport& report) {
+    report = WatertightReport();
+    if (!pool.isResident()) {
+        std::cerr << "The control points are not in memory, unable to check"
+                  << std::endl;
+        return false;
+    }
+    const auto& points = pool.controlPoints().points();
+
+    GLVec3 lower = GLVec3::Constant(std::numeric_limits<float>::max());
+    GLVec3 upper = -lower;
+    for (const auto& cp : points) {
+        lower = lower.cwiseMin(cp.position);
+        upper = upper.cwiseMax(cp.position);
+    }
+    const float tolerance = points.empty() ? 0.f
+                                           : (upper - lower).maxCoeff() * 1e-6f;
+
+    // the sides of each edge, keyed by its control points in canonical order
+    std::map<std::vector<float>, std::vector<EdgeSide>> edges;
+    HPoints controlPoints;
+    std::vector<float> key;
+    std::vector<float> parameters;
+    const auto& patches = pool.patches();
+    for (std::size_t p = 0; p < patches.size(); ++p) {
+        const auto& patch = patches[p];
+        if (patch.isCurve() || patch.countU > BEZIER_MAX_CP
+            || patch.countV > BEZIER_MAX_CP) {
+            continue;
+        }
+        controlPoints.resize(patch.count());
+        for (GLuint i = 0; i < patch.count(); ++i) {
+            controlPoints[i] = points[patch.first + i].homogeneous();
+        }
+
+        const auto levels = outerLevels(points, patch, params);
+        for (GLuint e = 0; e < 4; ++e) {
+            const PatchEdge edge = patchEdge(patch, e);
+            const bool reversed = reversedEdge(points, edge);
+
+            key.clear();
+            for (GLuint k = 0; k < edge.count; ++k) {
+                const GLuint i = reversed ? edge.count - 1 - k : k;
+                const GLVec4 h = points[edge.first + i * edge.stride].homogeneous();
+                key.insert(key.end(), h.data(), h.data() + 4);
+            }
+
+            edgeParameters(levels[e], params.spacing, parameters);
+            EdgeSide side{static_cast<GLuint>(p), e,
+                          static_cast<GLuint>(parameters.size() - 1), {}};
+            edgeVertices(controlPoints, patch, e, parameters, side.vertices);
+            if (reversed) {
+                std::reverse(side.vertices.begin(), side.vertices.end());
+            }
+            edges[key].push_back(std::move(side));
+        }
+    }
+
+    for (const auto& edge : edges) {
+        const auto& sides = edge.second;
+        if (sides.size() == 1) {
+            ++report.openEdges;
+            continue;
+        }
+        ++report.sharedEdges;
+        // non manifold edges: every side is compared to the first one
+        for (std::size_t s = 1; s < sides.size(); ++s) {
+            const float gap = gapBetween(sides[0], sides[s]);
+            if (sides[0].segments != sides[s].segments || gap > tolerance) {
+                report.cracks.push_back({sides[0].patch, sides[0].edge,
+                                         sides[s].patch, sides[s].edge,
+                                         sides[0].segments, sides[s].segments,
+                                         gap});
+            }
+        }
+    }
+    return true;
+}
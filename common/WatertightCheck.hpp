@@ -0,0 +1,45 @@
+#ifndef BEZIER_WATERTIGHT_CHECK_HPP
+#define BEZIER_WATERTIGHT_CHECK_HPP
+
+#include "PatchPool.hpp"
+#include "TessLevels.hpp"
+
+#include <vector>
+
+/**
+ * Edge shared by two patches whose tessellations do not match.
+ */
+struct EdgeCrack {
+    GLuint patchA;
+    GLuint edgeA;
+    GLuint patchB;
+    GLuint edgeB;
+    GLuint segmentsA;
+    GLuint segmentsB;
+    // largest distance from a vertex of one side to the other side
+    float gap;
+};
+
+struct WatertightReport {
+    std::size_t sharedEdges = 0;
+    // edges of a single patch, the border of the surface
+    std::size_t openEdges = 0;
+    std::vector<EdgeCrack> cracks;
+
+    inline bool watertight() const { return cracks.empty(); }
+};
+
+/**
+ * Tessellate the edges of the rectangular patches of pool on the CPU, with
+ * the levels the shaders use for params, and compare the two sides of each
+ * shared edge. Edges are shared when their control points are the same,
+ * in either direction. A shared edge cracks when its sides have different
+ * segment counts (T-junctions) or vertices farther apart than a millionth
+ * of the scene size.
+ *
+ * Needs the CPU copy of the control points, returns false without it.
+ */
+bool checkWatertight(const PatchPool& pool, const TessLevelParams& params,
+                     WatertightReport& report);
+
+#endif //BEZIER_WATERTIGHT_CHECK_HPP
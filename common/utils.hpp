@@ -1,21 +1,91 @@
 #ifndef BEZIER_UTILS_HPP
 #define BEZIER_UTILS_HPP
 
+#include "EmbeddedResources.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <fstream>
+#include <iostream>
 
 #define MACRO_STR(s) #s
 #define MACRO_XSTR(s) MACRO_STR(s)
 #define RESOURCE_PATH std::string(MACRO_XSTR(RESOURCES)) + '/'
 
+/**
+ * $BEZIER_RESOURCE_DIR, the directory the resources are read from during
+ * development (empty when unset).
+ */
+inline std::string resourceOverrideDirectory() {
+    const char* dir = std::getenv("BEZIER_RESOURCE_DIR");
+    return dir ? dir : "";
+}
+
+/**
+ * Content of a resource (path relative to resources/). The shaders are
+ * embedded in the binary at build time; during development, setting
+ * BEZIER_RESOURCE_DIR reads them from that directory instead, so edits are
+ * picked up without rebuilding.
+ */
 inline std::string readFile(const std::string& path) {
-    const std::string full_path = RESOURCE_PATH + path;
-    std::ifstream file{full_path, std::ifstream::in};
-    if (!file.good()) {
-        std::cerr << "Unable to open file '" << full_path << "'" << std::endl;
-        return "";
-    }
-    return std::string(std::istreambuf_iterator<char>(file),
-                       std::istreambuf_iterator<char>());
+    const std::string dir = resourceOverrideDirectory();
+    if (!dir.empty()) {
+        const std::string full_path = dir + '/' + path;
+        std::ifstream file{full_path, std::ifstream::in};
+        if (file.good()) {
+            return std::string(std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>());
+        }
+        std::cerr << "Unable to open file '" << full_path
+                  << "', using the embedded copy" << std::endl;
+    }
+
+    if (const auto* resource = findEmbeddedResource(path)) {
+        return std::string(resource->data, resource->size);
+    }
+    std::cerr << "Unknown resource '" << path << "'" << std::endl;
+    return "";
+}
+
+/**
+ * Per user cache of the linked shader programs: $BEZIER_SHADER_CACHE (empty
+ * to disable it), else $XDG_CACHE_HOME/bezier/shaders or
+ * ~/.cache/bezier/shaders (%LOCALAPPDATA%\bezier\shaders on Windows).
+ */
+inline std::string shaderCacheDirectory() {
+    if (const char* dir = std::getenv("BEZIER_SHADER_CACHE")) {
+        return dir;
+    }
+#ifdef _WIN32
+    if (const char* local = std::getenv("LOCALAPPDATA")) {
+        return std::string(local) + "\\bezier\\shaders";
+    }
+#else
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        return std::string(xdg) + "/bezier/shaders";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/bezier/shaders";
+    }
+#endif
+    return "";
+}
+
+/**
+ * Case insensitive check of the extension of path (given without the dot).
+ */
+inline bool hasExtension(const std::string& path, const std::string& extension) {
+    if (path.size() <= extension.size()
+        || path[path.size() - extension.size() - 1] != '.') {
+        return false;
+    }
+    return std::equal(extension.begin(), extension.end(),
+                      path.end() - extension.size(),
+                      [](char a, char b) {
+                          return std::tolower(static_cast<unsigned char>(a))
+                                 == std::tolower(static_cast<unsigned char>(b));
+                      });
 }
 
 enum class DrawMode {
@@ -1,61 +1,90 @@
 #include "Viewer.hpp"
 
+#include "ControlNetFile.hpp"
+#include "easycppogl_src/portable_file_dialogs.h"
+
 #include "utils.hpp"
 
 #define SELECTION_RADIUS 0.01
 
-Viewer::Viewer() :
+namespace {
+    // curves larger than this use the generic shader (see tessEval.glsl)
+    constexpr GLuint MAX_SPECIALIZED_CP = 8;
+
+    // the spacing is in the upper bits of the keys, the point count below
+    constexpr GLuint SPACING_SHIFT = 30;
+
+    inline GLuint curveKey(GLuint count, TessSpacing spacing) {
+        return static_cast<GLuint>(spacing) << SPACING_SHIFT | count;
+    }
+
+    std::vector<std::string> curveDefines(GLuint key) {
+        const auto spacing = static_cast<TessSpacing>(key >> SPACING_SHIFT);
+        const GLuint count = key & ((1u << SPACING_SHIFT) - 1);
+
+        std::vector<std::string> defines;
+        if (spacing != TessSpacing::Equal) {
+            defines.push_back("SPACING " + spacingQualifier(spacing));
+        }
+        if (count <= MAX_SPECIALIZED_CP) {
+            defines.push_back("CP_COUNT " + std::to_string(count));
+        }
+        return defines;
+    }
+}
+
+Viewer::Viewer(const std::string& modelPath) :
         movingPointIndex(-1),
-        vao(nullptr),
-        outerTesselationLevel1(50),
+        bezierCurveShaders({
+            {GL_VERTEX_SHADER, "shaders/rational_vert.glsl"},
+            {GL_TESS_CONTROL_SHADER, "shaders/bezier_curves/tessCont.glsl"},
+            {GL_TESS_EVALUATION_SHADER, "shaders/bezier_curves/tessEval.glsl"},
+            {GL_FRAGMENT_SHADER, "shaders/basic_frag.glsl"}
+        }, "bezier_curves", curveDefines),
+        modelPath(modelPath),
+        outerTesselationLevel1(50.f),
+        spacing(TessSpacing::Equal),
         color{1., 0., 0., 1.},
         pointsSize(10) {
 }
 
-void Viewer::init_vao() {
-    controlPoints = {
-            GLVec3{-0.5, -0.5, +0.0},
-            GLVec3{-0.3, +0.25, +0.0},
-            GLVec3{+0.5, +0.5, +0.0},
-            GLVec3{+0.0, -0.75, +0.0},
-            GLVec3{+0.5, -0.5, +0.0},
-    };
-
-    vbo = VBO::create(controlPoints);
+void Viewer::loadModel(const std::string& path) {
+    stream.stop();
+    pool.clear();
+    pool.upload();
 
-    vao = VAO::create({{0, vbo}});
+    if (hasExtension(path, "cnet")) {
+        ControlNetFile::read(path, pool);
+    } else {
+        stream.start(path);
+    }
+    modelPath = path;
 }
 
 void Viewer::init_ogl() {
-    bezierCurveShaderProgram = ShaderProgram::create({
-        {
-            GL_VERTEX_SHADER,
-            readFile("shaders/basic_vert.glsl")
-        }, {
-            GL_TESS_CONTROL_SHADER,
-            readFile("shaders/bezier_curves/tessCont.glsl")
-        }, {
-            GL_TESS_EVALUATION_SHADER,
-            readFile("shaders/bezier_curves/tessEval.glsl")
-        }, {
-            GL_FRAGMENT_SHADER,
-            readFile("shaders/basic_frag.glsl")
-        }
-    }, "");
+    ShaderProgram::set_binary_cache(shaderCacheDirectory());
 
+    bezierCurveShaders.init(shaders);
+    // cubic curves are most of the data, their variant is built upfront
+    bezierCurveShaders.get(curveKey(4, spacing));
 
-    pointsShaderProgram = ShaderProgram::create({
-        {
-            GL_VERTEX_SHADER,
-            readFile("shaders/basic_vert.glsl")
-        }, {
-            GL_FRAGMENT_SHADER,
-            readFile("shaders/basic_frag.glsl")
-        }
-    }, "");
+    pointsShaderProgram = shaders.create({
+        {GL_VERTEX_SHADER, "shaders/basic_vert.glsl"},
+        {GL_FRAGMENT_SHADER, "shaders/basic_frag.glsl"}
+    }, "points");
 
+    controlPointsShaderProgram = shaders.create({
+        {GL_VERTEX_SHADER, "shaders/controlPoints_vert.glsl"},
+        {GL_FRAGMENT_SHADER, "shaders/vertexColor_frag.glsl"}
+    }, "control_points");
+
+    const std::string resourceDir = resourceOverrideDirectory();
+    if (!resourceDir.empty()) {
+        shaders.enableHotReload(resourceDir, create_shared_context());
+    }
 
-    init_vao();
+    loadModel(modelPath.empty() ? RESOURCE_PATH + "models/curves.obj"
+                                : modelPath);
 
     set_scene_center(GLVec3(0, 0, 0));
     set_scene_radius(3.0);
@@ -66,60 +95,154 @@ void Viewer::init_ogl() {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
+void Viewer::close_ogl() {
+    // the programs are deleted while the window context still exists
+    shaders.shutdown();
+    bezierCurveShaders.release();
+    pointsShaderProgram.reset();
+    controlPointsShaderProgram.reset();
+}
+
 void Viewer::draw_ogl() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glPointSize(pointsSize);
 
-    const auto& cpCount = vao->length();
+    shaders.update();
+    stream.drain(pool);
 
-    bezierCurveShaderProgram->bind();
+    const auto& vao = pool.controlPoints().getVao();
+    const auto cpCount = static_cast<GLsizei>(pool.controlPoints().gpuSize());
+    if (cpCount == 0) {
+        return;
+    }
 
-    set_uniform_value("uColor", GLVec4(color));
-    set_uniform_value("uOuterLevel1", static_cast<GLfloat>(outerTesselationLevel1));
-    set_uniform_value("uCPCount", static_cast<GLuint>(cpCount));
+    batches.update(pool);
 
     vao->bind();
-    glPatchParameteri(GL_PATCH_VERTICES, cpCount);
-    glDrawArrays(GL_PATCHES, 0, cpCount);
+    const ShaderProgram* bound = nullptr;
+    for (const auto& batch : batches.batches()) {
+        if (!batch.isCurve()) {
+            continue;
+        }
+        const auto& program = bezierCurveShaders.get(curveKey(batch.countU, spacing));
+        if (!program) {
+            continue;
+        }
+        if (program.get() != bound) {
+            program->bind();
+            bound = program.get();
+
+            set_uniform_value("uColor", GLVec4(color));
+            set_uniform_value("uOuterLevel1", outerTesselationLevel1);
+        }
+        // the spacing variants of the large curves are not specialized
+        if (program == bezierCurveShaders.generic()
+            || batch.countU > MAX_SPECIALIZED_CP) {
+            set_uniform_value("uCPCount", batch.countU);
+        }
+        glPatchParameteri(GL_PATCH_VERTICES, batch.patchVertices());
+        batch.draw(GL_PATCHES);
+    }
     vao->unbind();
 
-    bezierCurveShaderProgram->unbind();
+    ShaderProgram::unbind();
 
 
     pointsShaderProgram->bind();
     vao->bind();
 
     set_uniform_value("uColor", GLVec4({0., 1., 0., .3}));
-    glDrawArrays(GL_LINE_STRIP, 0, cpCount);
+    for (const auto& batch : batches.batches()) {
+        if (batch.isCurve()) {
+            batch.draw(GL_LINE_STRIP);
+        }
+    }
+
+    vao->unbind();
+    pointsShaderProgram->unbind();
+
 
-    set_uniform_value("uColor", GLVec4({0., 1., 0., 1.}));
+    controlPointsShaderProgram->bind();
+    vao->bind();
+
+    set_uniform_value("projMatrix", GLMat4::Identity().eval());
+    set_uniform_value("mvMatrix", GLMat4::Identity().eval());
     glDrawArrays(GL_POINTS, 0, cpCount);
 
     vao->unbind();
-    pointsShaderProgram->unbind();
+    controlPointsShaderProgram->unbind();
 }
 
 void Viewer::interface_ogl() {
     bool ui_tesselation_level_show = true;
     ImGui::Begin("Parameters", &ui_tesselation_level_show);
 
+    if (ImGui::TreeNode("File")) {
+        if (ImGui::Button("Open")) {
+            const auto paths = pfd::open_file(
+                    "Open control net", "",
+                    {"Control nets", "*.cnet *.obj *.igs *.iges"}
+            ).result();
+            if (!paths.empty()) {
+                loadModel(paths.front());
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) {
+            const auto path = pfd::save_file(
+                    "Save control net", modelPath, {"Control nets", "*.cnet"}
+            ).result();
+            if (!path.empty() && ControlNetFile::write(path, pool)) {
+                modelPath = path;
+            }
+        }
+
+        ImGui::TreePop();
+    }
+
     if (ImGui::TreeNode("Rendering")) {
         ImGui::ColorEdit4("Color", color);
         ImGui::SliderInt("CP Size", &pointsSize, 0, 40);
+        bool frameTimes = show_frame_stats();
+        if (ImGui::Checkbox("Frame times (F3)", &frameTimes)) {
+            set_show_frame_stats(frameTimes);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save trace (F4)")) {
+            save_trace();
+        }
 
         ImGui::TreePop();
     }
 
     if (ImGui::TreeNode("Parameters")) {
-        ImGui::SliderInt(
+        ImGui::SliderFloat(
                 "Points Count",
                 &outerTesselationLevel1,
-                0, 100
+                0.f, 100.f
+        );
+        // the fractional spacings do not pop when the count changes
+        ImGui::SliderInt(
+                ("Spacing - " + to_string(spacing)).c_str(),
+                reinterpret_cast<int*>(&spacing),
+                0, 2
         );
 
         ImGui::TreePop();
     }
 
+    if (ImGui::TreeNode("Weights")) {
+        for (size_t i = 0; i < pool.controlPoints().size(); ++i) {
+            const std::string label = "CP " + std::to_string(i);
+            if (ImGui::SliderFloat(label.c_str(), &pool.controlPoints()[i].weight,
+                                   0.05f, 10.f, "%.3f", 2.f)) {
+                pool.controlPoints().update(i, 1);
+            }
+        }
+
+        ImGui::TreePop();
+    }
+
     ImGui::End();
 }
 
@@ -133,19 +256,25 @@ GLVec3 Viewer::windowToGlCoord(GLVec2 winCoord) {
 
 void Viewer::mouse_press_ogl(int32_t button, double x, double y) {
     GLVec3 glCoord = windowToGlCoord({x, y});
-    for (size_t i = 0; i < controlPoints.size(); ++i) {
-        const auto& point = controlPoints[i];
+    for (size_t i = 0; i < pool.controlPoints().size(); ++i) {
+        const auto& point = pool.controlPoints()[i].position;
         if (glCoord.x() >= point.x() - SELECTION_RADIUS 
          && glCoord.x() <= point.x() + SELECTION_RADIUS
          && glCoord.y() >= point.y() - SELECTION_RADIUS
          && glCoord.y() <= point.y() + SELECTION_RADIUS) {
              movingPointIndex = i;
+             pool.controlPoints()[i].flags |= CP_SELECTED;
+             pool.controlPoints().update(i, 1);
              break;
         }
     }
 }
 
 void Viewer::mouse_release_ogl(int32_t button, double x, double y) {
+    if (movingPointIndex >= 0) {
+        pool.controlPoints()[movingPointIndex].flags &= ~CP_SELECTED;
+        pool.controlPoints().update(movingPointIndex, 1);
+    }
     movingPointIndex = -1;
 }
 
@@ -154,6 +283,6 @@ void Viewer::mouse_move_ogl(double x, double y) {
         return;
     }
 
-    controlPoints[movingPointIndex] = windowToGlCoord({x, y});
-    vbo->update(controlPoints);
+    pool.controlPoints()[movingPointIndex].position = windowToGlCoord({x, y});
+    pool.controlPoints().update(movingPointIndex, 1);
 }
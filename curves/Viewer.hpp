@@ -4,12 +4,19 @@
 #include "easycppogl_src/gl_viewer.h"
 #include "easycppogl_src/shader_program.h"
 
+#include "PatchBatches.hpp"
+#include "PatchPool.hpp"
+#include "PatchStream.hpp"
+#include "ShaderLibrary.hpp"
+#include "TessLevels.hpp"
+
 using namespace EZCOGL;
 
 class Viewer : public GLViewer {
 public:
-    Viewer();
+    explicit Viewer(const std::string& modelPath = "");
     void init_ogl() override;
+    void close_ogl() override;
     void draw_ogl() override;
     void interface_ogl() override;
 
@@ -20,21 +27,26 @@ private:
 	void mouse_move_ogl(double x, double y) override;
 
 private:
-    void init_vao();
+    void loadModel(const std::string& path);
 
 private:
     GLVec3 windowToGlCoord(GLVec2 winCoord);
 
 private:
-    std::shared_ptr<ShaderProgram> bezierCurveShaderProgram;
+    ShaderLibrary shaders;
+    // one variant per control point count and spacing, see curveKey
+    ShaderVariants bezierCurveShaders;
     std::shared_ptr<ShaderProgram> pointsShaderProgram;
+    std::shared_ptr<ShaderProgram> controlPointsShaderProgram;
 
-    std::vector<GLVec3> controlPoints;
-    std::shared_ptr<VBO> vbo;
-    std::shared_ptr<VAO> vao;
+    PatchPool pool;
+    PatchBatches batches;
+    PatchStream stream;
+    std::string modelPath;
 
 private:
-    int outerTesselationLevel1;
+    float outerTesselationLevel1;
+    TessSpacing spacing;
 
     float color[4];
     int pointsSize;
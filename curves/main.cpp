@@ -1,7 +1,7 @@
 #include "Viewer.hpp"
 
-int main() {
-    Viewer viewer;
+int main(int argc, char** argv) {
+    Viewer viewer(argc > 1 ? argv[1] : "");
     viewer.set_size(1280, 720);
     viewer.launch3d();
 
@@ -0,0 +1,141 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#include "buffer_pool.h"
+
+#include <algorithm>
+
+namespace EZCOGL
+{
+
+const GLsizeiptr BufferPool::DEFAULT_CAPACITY;
+
+BufferPool::BufferPool(GLsizeiptr initial_capacity) :
+	capacity_(std::max<GLsizeiptr>(initial_capacity, 4)),
+	used_(0),
+	revision_(0)
+{
+	free_[0] = capacity_;
+}
+
+void BufferPool::grow(GLsizeiptr min_capacity)
+{
+	GLsizeiptr capacity = vbo_ ? std::max(min_capacity, 2 * capacity_) : min_capacity;
+	capacity = (capacity + 3) / 4 * 4;
+
+	auto grown = VBO::create(1);
+	grown->allocate(GLuint(capacity / GLsizeiptr(sizeof(GLfloat))));
+	if (vbo_)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, vbo_->id());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown->id());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity_);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	vbo_ = grown;
+	++revision_;
+
+	// the new space extends the last free range if it ends the buffer
+	if (capacity > capacity_)
+	{
+		GLintptr start = capacity_;
+		if (!free_.empty())
+		{
+			auto last = std::prev(free_.end());
+			if (last->first + last->second == capacity_)
+			{
+				start = last->first;
+				free_.erase(last);
+			}
+		}
+		free_[start] = capacity - start;
+	}
+	capacity_ = capacity;
+}
+
+BufferPool::Range BufferPool::allocate(GLsizeiptr bytes, GLsizeiptr alignment)
+{
+	if (bytes <= 0)
+		return Range{0, 0};
+	alignment = std::max<GLsizeiptr>(alignment, 1);
+
+	if (!vbo_)
+		grow(capacity_);
+
+	for (;;)
+	{
+		for (auto it = free_.begin(); it != free_.end(); ++it)
+		{
+			GLintptr start = (it->first + alignment - 1) / alignment * alignment;
+			GLintptr end = it->first + it->second;
+			if (start + bytes > end)
+				continue;
+
+			GLintptr before = it->first;
+			free_.erase(it);
+			if (start > before)
+				free_[before] = start - before;
+			if (start + bytes < end)
+				free_[start + bytes] = end - (start + bytes);
+			used_ += bytes;
+			return Range{start, bytes};
+		}
+		grow(capacity_ + bytes + alignment);
+	}
+}
+
+void BufferPool::release(const Range& range)
+{
+	if (!range.valid())
+		return;
+	used_ -= range.size;
+
+	GLintptr start = range.offset;
+	GLintptr end = range.offset + range.size;
+	auto next = free_.lower_bound(start);
+	if (next != free_.end() && next->first == end)
+	{
+		end += next->second;
+		next = free_.erase(next);
+	}
+	if (next != free_.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == start)
+		{
+			start = previous->first;
+			free_.erase(previous);
+		}
+	}
+	free_[start] = end - start;
+}
+
+void BufferPool::sub_data(GLintptr offset, GLsizeiptr bytes, const void* data)
+{
+	if (!vbo_ || bytes <= 0)
+		return;
+	vbo_->bind();
+	glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+	VBO::unbind();
+}
+
+}
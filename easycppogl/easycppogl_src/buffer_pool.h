@@ -0,0 +1,107 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#ifndef EASY_CPP_OGL_BUFFER_POOL_H_
+#define EASY_CPP_OGL_BUFFER_POOL_H_
+
+#include <GL/gl3w.h>
+#include <map>
+#include <memory>
+#include "vbo.h"
+
+namespace EZCOGL
+{
+
+/**
+ * @brief one large GL buffer shared by many objects, each one using a range of it
+ * (vertices, indices...) instead of a buffer of its own: creating and destroying
+ * objects does not create and destroy GL buffers.
+ * Free space is kept in a first fit free list whose neighbour ranges are merged.
+ * When full the buffer grows by copy: offsets stay valid but the VBO changes,
+ * the VAOs using it must be rebuilt when revision() changes.
+ */
+class BufferPool
+{
+public:
+	struct Range
+	{
+		GLintptr offset;
+		GLsizeiptr size;
+
+		inline bool valid() const { return size > 0; }
+	};
+
+protected:
+	SP_VBO vbo_;
+	GLsizeiptr capacity_;
+	GLsizeiptr used_;
+	GLuint revision_;
+	// offset -> size
+	std::map<GLintptr, GLsizeiptr> free_;
+
+	void grow(GLsizeiptr min_capacity);
+
+public:
+	static const GLsizeiptr DEFAULT_CAPACITY = 1 << 20;
+
+	/**
+	 * @brief the buffer is created by the first allocate
+	 */
+	explicit BufferPool(GLsizeiptr initial_capacity = DEFAULT_CAPACITY);
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	/**
+	 * @brief range of bytes bytes whose offset is a multiple of alignment (any positive value,
+	 * e.g. the size of a vertex so that offset / size is a base vertex)
+	 */
+	Range allocate(GLsizeiptr bytes, GLsizeiptr alignment = 4);
+
+	/**
+	 * @brief give back a range returned by allocate
+	 */
+	void release(const Range& range);
+
+	/**
+	 * @brief write bytes bytes at offset (in bytes from the start of the buffer)
+	 */
+	void sub_data(GLintptr offset, GLsizeiptr bytes, const void* data);
+
+	/**
+	 * @brief the buffer (its vector dimension is meaningless, use typed VertexAttribute)
+	 */
+	inline const SP_VBO& vbo() const { return vbo_; }
+
+	/**
+	 * @brief changes each time the buffer is replaced by a larger one
+	 */
+	inline GLuint revision() const { return revision_; }
+
+	inline GLsizeiptr capacity() const { return capacity_; }
+
+	inline GLsizeiptr used() const { return used_; }
+
+	inline std::size_t free_range_count() const { return free_.size(); }
+};
+
+}
+#endif
@@ -54,6 +54,8 @@ public:
 
 	static void unbind();
 
+	inline GLuint id() const { return id_; }
+
 	virtual void resize(int w, int h);
 
 	inline GLint width() const { return tex_.front()->width(); }
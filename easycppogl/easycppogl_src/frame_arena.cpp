@@ -0,0 +1,80 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace EZCOGL
+{
+
+const std::size_t FrameArena::DEFAULT_BLOCK_SIZE;
+
+FrameArena::FrameArena(std::size_t block_size) :
+	block_size_(block_size),
+	current_(0),
+	offset_(0),
+	used_(0)
+{}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+	while (current_ < blocks_.size())
+	{
+		Block& b = blocks_[current_];
+		std::uintptr_t base = reinterpret_cast<std::uintptr_t>(b.data.get());
+		std::uintptr_t aligned = (base + offset_ + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+		std::size_t end = std::size_t(aligned - base) + bytes;
+		if (end <= b.size)
+		{
+			used_ += end - offset_;
+			offset_ = end;
+			return reinterpret_cast<void*>(aligned);
+		}
+		++current_;
+		offset_ = 0;
+	}
+
+	// new block, at least as large as the previous one so that their number stays small
+	std::size_t size = std::max(block_size_, bytes + alignment);
+	if (!blocks_.empty())
+		size = std::max(size, blocks_.back().size);
+	blocks_.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+	current_ = blocks_.size() - 1;
+	offset_ = 0;
+	return allocate(bytes, alignment);
+}
+
+void FrameArena::reset()
+{
+	if (blocks_.size() > 1)
+	{
+		std::size_t total = capacity();
+		blocks_.clear();
+		blocks_.push_back(Block{std::unique_ptr<char[]>(new char[total]), total});
+	}
+	current_ = 0;
+	offset_ = 0;
+	used_ = 0;
+}
+
+}
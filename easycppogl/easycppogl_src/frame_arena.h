@@ -0,0 +1,135 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#ifndef EASY_CPP_OGL_FRAME_ARENA_H_
+#define EASY_CPP_OGL_FRAME_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace EZCOGL
+{
+
+/**
+ * @brief linear allocator for the data living one frame (draw lists, visible sets...)
+ * allocation is a pointer bump, nothing is freed until reset, called by GLViewer
+ * before each frame. When a frame needed several blocks, reset merges them in one,
+ * so after a few frames a frame costs no heap allocation at all.
+ */
+class FrameArena
+{
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		std::size_t size;
+	};
+
+	std::vector<Block> blocks_;
+	std::size_t block_size_;
+	std::size_t current_;
+	std::size_t offset_;
+	std::size_t used_;
+
+public:
+	static const std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	explicit FrameArena(std::size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	/**
+	 * @brief memory for bytes bytes aligned on alignment (a power of 2), valid until reset
+	 */
+	void* allocate(std::size_t bytes, std::size_t alignment);
+
+	/**
+	 * @brief release everything allocated since the last reset
+	 */
+	void reset();
+
+	/**
+	 * @brief bytes allocated since the last reset (alignment padding included)
+	 */
+	inline std::size_t bytes_used() const { return used_; }
+
+	inline std::size_t capacity() const
+	{
+		std::size_t total = 0;
+		for (const auto& b : blocks_)
+			total += b.size;
+		return total;
+	}
+};
+
+/**
+ * @brief STL allocator taking its memory from a FrameArena, deallocate does nothing
+ */
+template <typename T>
+class ArenaAllocator
+{
+	FrameArena* arena_;
+
+public:
+	using value_type = T;
+
+	inline ArenaAllocator(FrameArena& arena) :
+		arena_(&arena)
+	{}
+
+	template <typename U>
+	inline ArenaAllocator(const ArenaAllocator<U>& other) :
+		arena_(other.arena())
+	{}
+
+	inline T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	inline void deallocate(T*, std::size_t)
+	{}
+
+	inline FrameArena* arena() const { return arena_; }
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena() != b.arena();
+}
+
+/**
+ * @brief vector in a FrameArena, reserve it when the size is known:
+ * growing leaves the previous buffers in the arena until reset
+ */
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+}
+#endif
@@ -0,0 +1,255 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#include "frame_stats.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+namespace EZCOGL
+{
+
+TimeRing::TimeRing(std::size_t capacity) :
+	values_(std::max<std::size_t>(capacity, 1), 0.f),
+	next_(0),
+	count_(0)
+{}
+
+void TimeRing::push(float ms)
+{
+	values_[next_] = ms;
+	next_ = (next_ + 1) % values_.size();
+	count_ = std::min(count_ + 1, values_.size());
+}
+
+float TimeRing::percentile(float fraction) const
+{
+	if (count_ == 0)
+		return 0.f;
+
+	sorted_.clear();
+	for (std::size_t i = 0; i < count_; ++i)
+		sorted_.push_back(at(i));
+
+	std::size_t rank = std::size_t(std::ceil(double(fraction) * double(count_)));
+	rank = std::min(std::max<std::size_t>(rank, 1), count_) - 1;
+	std::nth_element(sorted_.begin(), sorted_.begin() + long(rank), sorted_.end());
+	return sorted_[rank];
+}
+
+const std::size_t FrameStats::DEFAULT_CAPACITY;
+const std::size_t FrameStats::GPU_LATENCY;
+const std::size_t FrameStats::MAX_SPIKES;
+const std::size_t FrameStats::MIN_SPIKE_HISTORY;
+
+FrameStats::FrameStats(std::size_t capacity) :
+	cpu_ms_(capacity),
+	gpu_ms_(capacity),
+	frame_open_(false),
+	frame_count_(0),
+	gpu_next_(0),
+	gpu_ready_(false),
+	spike_factor_(2.f)
+{
+	for (auto& f : gpu_frames_)
+		f = GpuFrame{{0, 0}, false};
+}
+
+void FrameStats::begin_frame()
+{
+	Clock::time_point now = Clock::now();
+	if (frame_open_)
+		close_frame(now);
+	frame_start_ = now;
+	frame_open_ = true;
+	passes_.clear();
+	pass_starts_.clear();
+
+	if (!gpu_ready_)
+	{
+		for (auto& f : gpu_frames_)
+			glGenQueries(2, f.queries);
+		gpu_ready_ = true;
+	}
+
+	// results come in order, stop at the first one not available yet
+	for (std::size_t i = 0; i < GPU_LATENCY; ++i)
+	{
+		GpuFrame& f = gpu_frames_[(gpu_next_ + i) % GPU_LATENCY];
+		if (!f.pending)
+			continue;
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(f.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+			break;
+		read_gpu(f);
+	}
+
+	// a GPU late by more than GPU_LATENCY frames is waited for
+	GpuFrame& f = gpu_frames_[gpu_next_];
+	if (f.pending)
+		read_gpu(f);
+	glQueryCounter(f.queries[0], GL_TIMESTAMP);
+}
+
+void FrameStats::end_frame()
+{
+	if (!frame_open_ || !gpu_ready_)
+		return;
+	GpuFrame& f = gpu_frames_[gpu_next_];
+	glQueryCounter(f.queries[1], GL_TIMESTAMP);
+	f.pending = true;
+	gpu_next_ = (gpu_next_ + 1) % GPU_LATENCY;
+}
+
+std::size_t FrameStats::begin_pass(const char* name)
+{
+	passes_.push_back(Pass{name, 0.f});
+	pass_starts_.push_back(Clock::now());
+	return passes_.size() - 1;
+}
+
+void FrameStats::end_pass(std::size_t index)
+{
+	if (index >= passes_.size())
+		return;
+	std::chrono::duration<float, std::milli> d = Clock::now() - pass_starts_[index];
+	passes_[index].ms = d.count();
+}
+
+void FrameStats::release()
+{
+	if (!gpu_ready_)
+		return;
+	for (auto& f : gpu_frames_)
+	{
+		glDeleteQueries(2, f.queries);
+		f.pending = false;
+	}
+	gpu_ready_ = false;
+}
+
+void FrameStats::close_frame(Clock::time_point now)
+{
+	std::chrono::duration<float, std::milli> d = now - frame_start_;
+	float ms = d.count();
+
+	if (cpu_ms_.size() >= MIN_SPIKE_HISTORY)
+	{
+		float median = cpu_ms_.percentile(0.5f);
+		if (ms > spike_factor_ * median)
+		{
+			if (spikes_.size() == MAX_SPIKES)
+				spikes_.erase(spikes_.begin());
+			spikes_.push_back(Spike{frame_count_, ms, median, passes_});
+		}
+	}
+	cpu_ms_.push(ms);
+	++frame_count_;
+}
+
+void FrameStats::read_gpu(GpuFrame& frame)
+{
+	// GL_QUERY_RESULT waits for the result when it is not available
+	GLuint64 begin = 0;
+	GLuint64 end = 0;
+	glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+	gpu_ms_.push(float(double(end - begin) / 1e6));
+	frame.pending = false;
+}
+
+namespace
+{
+
+const int HISTOGRAM_BINS = 32;
+
+float ring_value(void* data, int i)
+{
+	return static_cast<const TimeRing*>(data)->at(std::size_t(i));
+}
+
+void plot_ring(const char* name, const TimeRing& ring)
+{
+	if (ring.size() == 0)
+		return;
+
+	float p50 = ring.percentile(0.5f);
+	float p95 = ring.percentile(0.95f);
+	float p99 = ring.percentile(0.99f);
+	ImGui::Text("%s p50 %.2f  p95 %.2f  p99 %.2f ms", name, double(p50), double(p95), double(p99));
+
+	// last frames, spikes above the graph are clipped
+	float top = std::max(2.f * p99, 1.f);
+	char overlay[64];
+	std::snprintf(overlay, sizeof(overlay), "%s, last %.2f ms", name, double(ring.last()));
+	ImGui::PushID(name);
+	ImGui::PlotHistogram("##timeline", ring_value, const_cast<TimeRing*>(&ring), int(ring.size()), 0,
+						 overlay, 0.f, top, ImVec2(0, 60));
+
+	// distribution of the times in [0, top], the last bin holding everything above
+	float bins[HISTOGRAM_BINS] = {};
+	for (std::size_t i = 0; i < ring.size(); ++i)
+	{
+		int b = int(ring.at(i) / top * HISTOGRAM_BINS);
+		++bins[std::min(std::max(b, 0), HISTOGRAM_BINS - 1)];
+	}
+	std::snprintf(overlay, sizeof(overlay), "0 - %.1f ms", double(top));
+	ImGui::PlotHistogram("##distribution", bins, HISTOGRAM_BINS, 0, overlay, 0.f, FLT_MAX, ImVec2(0, 60));
+	ImGui::PopID();
+}
+
+}
+
+void FrameStats::interface(bool* open)
+{
+	ImGui::Begin("Frame times", open);
+
+	plot_ring("CPU", cpu_ms_);
+	plot_ring("GPU", gpu_ms_);
+
+	ImGui::Separator();
+	ImGui::SliderFloat("Spike factor", &spike_factor_, 1.5f, 10.f);
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+		spikes_.clear();
+
+	// newest first
+	for (auto s = spikes_.rbegin(); s != spikes_.rend(); ++s)
+	{
+		if (ImGui::TreeNode(reinterpret_cast<void*>(std::uintptr_t(s->frame)),
+							"frame %llu: %.2f ms (median %.2f)",
+							static_cast<unsigned long long>(s->frame), double(s->ms), double(s->median_ms)))
+		{
+			for (const auto& p : s->passes)
+				ImGui::BulletText("%s %.2f ms", p.name, double(p.ms));
+			ImGui::TreePop();
+		}
+	}
+
+	ImGui::End();
+}
+
+}
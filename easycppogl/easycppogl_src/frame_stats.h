@@ -0,0 +1,200 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#ifndef EASY_CPP_OGL_FRAME_STATS_H_
+#define EASY_CPP_OGL_FRAME_STATS_H_
+
+#include <GL/gl3w.h>
+
+#include "trace_profiler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace EZCOGL
+{
+
+/**
+ * @brief fixed size history of durations in milliseconds, the oldest overwritten first
+ */
+class TimeRing
+{
+	std::vector<float> values_;
+	std::size_t next_;
+	std::size_t count_;
+	mutable std::vector<float> sorted_;
+
+public:
+	explicit TimeRing(std::size_t capacity);
+
+	void push(float ms);
+
+	inline std::size_t size() const { return count_; }
+	inline std::size_t capacity() const { return values_.size(); }
+
+	/**
+	 * @brief i-th value from the oldest one
+	 */
+	inline float at(std::size_t i) const
+	{
+		return values_[(next_ + values_.size() - count_ + i) % values_.size()];
+	}
+
+	inline float last() const { return count_ ? at(count_ - 1) : 0.f; }
+
+	/**
+	 * @brief value below which lies the fraction of the history (nearest rank), 0 if empty
+	 */
+	float percentile(float fraction) const;
+};
+
+/**
+ * @brief per frame CPU and GPU times of the last frames, their percentiles, and the
+ * passes of the frames which took much longer than usual (spikes).
+ *
+ * The CPU time of a frame is the interval between two begin_frame, what the user sees.
+ * The GPU time is measured by timestamps queries between begin_frame and end_frame,
+ * read a few frames later without stalling. Passes are named CPU intervals of the
+ * current frame (nested or not), their names must outlive the stats (literals).
+ */
+class FrameStats
+{
+public:
+	struct Pass
+	{
+		const char* name;
+		float ms;
+	};
+
+	struct Spike
+	{
+		std::uint64_t frame;
+		float ms;
+		// p50 of the history when it happened
+		float median_ms;
+		std::vector<Pass> passes;
+	};
+
+	/**
+	 * @brief RAII pass, e.g. FrameStats::Scope scope(frame_stats(), "shadows");
+	 * also recorded as a TraceZone
+	 */
+	class Scope
+	{
+		FrameStats& stats_;
+		std::size_t index_;
+		TraceZone zone_;
+
+	public:
+		inline Scope(FrameStats& stats, const char* name) :
+			stats_(stats),
+			index_(stats.begin_pass(name)),
+			zone_(name)
+		{}
+
+		inline ~Scope() { stats_.end_pass(index_); }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	static const std::size_t DEFAULT_CAPACITY = 512;
+	// frames whose GPU timestamps are in flight
+	static const std::size_t GPU_LATENCY = 4;
+	static const std::size_t MAX_SPIKES = 16;
+	// frames of history before spikes are detected
+	static const std::size_t MIN_SPIKE_HISTORY = 30;
+
+	explicit FrameStats(std::size_t capacity = DEFAULT_CAPACITY);
+
+	FrameStats(const FrameStats&) = delete;
+	FrameStats& operator=(const FrameStats&) = delete;
+
+	/**
+	 * @brief close the previous frame and start a new one, the GL context being current
+	 */
+	void begin_frame();
+
+	/**
+	 * @brief end of the GPU commands of the frame (before the swap)
+	 */
+	void end_frame();
+
+	/**
+	 * @brief start a pass of the current frame, returns the index to give to end_pass
+	 */
+	std::size_t begin_pass(const char* name);
+
+	void end_pass(std::size_t index);
+
+	/**
+	 * @brief delete the GL queries, while the context still exists
+	 */
+	void release();
+
+	inline const TimeRing& cpu_times() const { return cpu_ms_; }
+	inline const TimeRing& gpu_times() const { return gpu_ms_; }
+	inline const std::vector<Spike>& spikes() const { return spikes_; }
+	inline void clear_spikes() { spikes_.clear(); }
+
+	/**
+	 * @brief a frame is a spike when it took more than factor times the median frame
+	 */
+	inline void set_spike_factor(float factor) { spike_factor_ = factor; }
+	inline float spike_factor() const { return spike_factor_; }
+
+	/**
+	 * @brief ImGui window with the percentiles, the histograms and the spikes
+	 */
+	void interface(bool* open = nullptr);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct GpuFrame
+	{
+		GLuint queries[2];
+		bool pending;
+	};
+
+	void close_frame(Clock::time_point now);
+	void read_gpu(GpuFrame& frame);
+
+	TimeRing cpu_ms_;
+	TimeRing gpu_ms_;
+
+	Clock::time_point frame_start_;
+	bool frame_open_;
+	std::uint64_t frame_count_;
+	std::vector<Clock::time_point> pass_starts_;
+	std::vector<Pass> passes_;
+
+	GpuFrame gpu_frames_[GPU_LATENCY];
+	std::size_t gpu_next_;
+	bool gpu_ready_;
+
+	float spike_factor_;
+	std::vector<Spike> spikes_;
+};
+
+}
+#endif
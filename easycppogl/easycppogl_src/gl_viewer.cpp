@@ -45,7 +45,7 @@ void GLViewer::set_size(int w, int h)
 	glfwSetWindowSize(window_,w,h);
 }
 
-GLViewer::GLViewer():
+GLViewer::GLViewer(bool visible):
 	need_redraw_(true),
 	wheel_sensitivity_(0.0025),
 	mouse_sensitivity_(0.005),
@@ -61,7 +61,8 @@ GLViewer::GLViewer():
 	last_click_time_(0),
 	vp_w_(0),
 	vp_h_(0),
-	show_imgui_(true)
+	show_imgui_(true),
+	show_frame_stats_(false)
 {
 	current_frame_ = &cam_;
 
@@ -82,7 +83,9 @@ GLViewer::GLViewer():
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 #endif
 
+	glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 	window_ = glfwCreateWindow(720, 720, "EOGL", nullptr, nullptr);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
 	if (window_ == nullptr)
 	{
 		std::cerr << "Failed to create Window!" << std::endl;
@@ -220,6 +223,11 @@ GLViewer::GLViewer():
 		if (k==GLFW_KEY_ESCAPE)
 			exit(0);
 
+		if (k==GLFW_KEY_F3 && a==GLFW_PRESS)
+			that->show_frame_stats_ = !that->show_frame_stats_;
+		if (k==GLFW_KEY_F4 && a==GLFW_PRESS)
+			that->save_trace();
+
 		that->shift_pressed_   = (m & GLFW_MOD_SHIFT);
 		that->control_pressed_ = (m & GLFW_MOD_CONTROL);
 		that->alt_pressed_     = (m & GLFW_MOD_ALT);
@@ -241,6 +249,25 @@ GLViewer::~GLViewer()
 {}
 
 
+GLFWwindow* GLViewer::create_shared_context()
+{
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* context = glfwCreateWindow(1, 1, "EOGL shared", nullptr, window_);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (context == nullptr)
+	{
+		std::cerr << "Failed to create shared context!" << std::endl;
+	}
+	return context;
+}
+
+
+bool GLViewer::save_trace()
+{
+	return TraceProfiler::write_chrome_trace("frame_trace.json");
+}
+
+
 void GLViewer::manip(MovingFrame* fr)
 {
 	if (fr != nullptr)
@@ -370,9 +397,11 @@ int GLViewer::launch2d()
 	FBO::initial_viewport_ = {0,0,vp_w_,vp_h_};
 	glViewport(0,0,vp_w_,vp_h_);
 
+	TraceProfiler::set_thread_name("render");
 	int32_t frame_counter = 0;
 	while (!glfwWindowShouldClose(window_))
 	{
+		TraceZone frame("frame");
 		if (++frame_counter == 50)
 		{
 			double now = glfwGetTime();
@@ -382,22 +411,38 @@ int GLViewer::launch2d()
 		}
 
 
-		glfwPollEvents();
+		frame_stats_.begin_frame();
+		{
+			FrameStats::Scope pass(frame_stats_, "events");
+			glfwPollEvents();
+		}
 		glfwMakeContextCurrent(window_);
-		this->draw_ogl();
+		frame_arena_.reset();
+		{
+			FrameStats::Scope pass(frame_stats_, "draw");
+			this->draw_ogl();
+		}
 		if (show_imgui_)
 		{
+			FrameStats::Scope pass(frame_stats_, "interface");
 			ImGui_ImplOpenGL3_NewFrame();
 			ImGui_ImplGlfw_NewFrame();
 			ImGui::NewFrame();
 			this->interface_ogl();
+			if (show_frame_stats_)
+				frame_stats_.interface(&show_frame_stats_);
 			ImGui::Render();
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
-		glfwSwapBuffers(window_);
+		frame_stats_.end_frame();
+		{
+			FrameStats::Scope pass(frame_stats_, "swap");
+			glfwSwapBuffers(window_);
+		}
 	}
-	glfwDestroyWindow(window_);
+	frame_stats_.release();
 	close_ogl();
+	glfwDestroyWindow(window_);
 	return EXIT_SUCCESS;
 }
 
@@ -413,9 +458,11 @@ int GLViewer::launch3d()
 	FBO::initial_viewport_ = {0,0,vp_w_,vp_h_};
 	glViewport(0,0,vp_w_,vp_h_);
 
+	TraceProfiler::set_thread_name("render");
 	int32_t frame_counter = 0;
 	while (!glfwWindowShouldClose(window_))
 	{
+		TraceZone frame("frame");
 		if (++frame_counter == 50)
 		{
 			double now = glfwGetTime();
@@ -424,23 +471,42 @@ int GLViewer::launch3d()
 			time_last_50_frames_ = now;
 		}
 
-		glfwPollEvents();
+		frame_stats_.begin_frame();
+		{
+			FrameStats::Scope pass(frame_stats_, "events");
+			glfwPollEvents();
+		}
 		glfwMakeContextCurrent(window_);
-		this->spin();
-		this->draw_ogl();
+		frame_arena_.reset();
+		{
+			FrameStats::Scope pass(frame_stats_, "spin");
+			this->spin();
+		}
+		{
+			FrameStats::Scope pass(frame_stats_, "draw");
+			this->draw_ogl();
+		}
 		if (show_imgui_)
 		{
+			FrameStats::Scope pass(frame_stats_, "interface");
 			ImGui_ImplOpenGL3_NewFrame();
 			ImGui_ImplGlfw_NewFrame();
 			ImGui::NewFrame();
 			this->interface_ogl();
+			if (show_frame_stats_)
+				frame_stats_.interface(&show_frame_stats_);
 			ImGui::Render();
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
-		glfwSwapBuffers(window_);
+		frame_stats_.end_frame();
+		{
+			FrameStats::Scope pass(frame_stats_, "swap");
+			glfwSwapBuffers(window_);
+		}
 	}
-	glfwDestroyWindow(window_);
+	frame_stats_.release();
 	close_ogl();
+	glfwDestroyWindow(window_);
 	return EXIT_SUCCESS;
 }
 
@@ -29,6 +29,8 @@
 #include "portable_file_dialogs.h"
 
 #include "camera.h"
+#include "frame_arena.h"
+#include "frame_stats.h"
 
 namespace EZCOGL
 {
@@ -64,12 +66,19 @@ protected:
 	double time_last_50_frames_;
 	double fps_;
 	bool show_imgui_;
+	FrameArena frame_arena_;
+	FrameStats frame_stats_;
+	bool show_frame_stats_;
 
 	void spin();
 
 public:
 
-	GLViewer();
+	/**
+	 * @brief create the window and its context; an invisible one renders offscreen only
+	 * (benchmarks, tests)
+	 */
+	explicit GLViewer(bool visible = true);
 
 	virtual ~GLViewer();
 
@@ -109,14 +118,43 @@ public:
 	inline int32_t width() const { return vp_w_; }
 	inline int32_t height() const { return vp_h_; }
 
+	/**
+	 * @brief allocator for the data of the current frame, reset before each draw_ogl
+	 */
+	inline FrameArena& frame_arena() { return frame_arena_; }
+
+	/**
+	 * @brief times of the last frames, drawn in their own window when shown (F3 toggles it);
+	 * draw_ogl may time its passes with FrameStats::Scope
+	 */
+	inline FrameStats& frame_stats() { return frame_stats_; }
+	inline bool show_frame_stats() const { return show_frame_stats_; }
+	inline void set_show_frame_stats(bool show) { show_frame_stats_ = show; }
+
+	/**
+	 * @brief write the zones recorded by the TraceProfiler (the last frames and the
+	 * workers) in a Chrome trace file of the working directory, F4 does it too
+	 */
+	bool save_trace();
+
 	void manip(MovingFrame* fr);
 
+	/**
+	 * @brief create an invisible window whose context shares its objects with the viewer one,
+	 * to be made current in a worker thread (e.g. to compile shaders in the background).
+	 * Must be called from the main thread, the caller destroys it with glfwDestroyWindow.
+	 */
+	GLFWwindow* create_shared_context();
+
 	virtual void mouse_press_ogl(int32_t button, double x, double y);
 	virtual void mouse_release_ogl(int32_t button, double x, double y);
 	virtual void mouse_dbl_click_ogl(int32_t button, double x, double y);
 	virtual void mouse_move_ogl(double x, double y);
 	virtual void mouse_wheel_ogl(double x, double y);
 	virtual void resize_ogl(int32_t w, int32_t h);
+	/**
+	 * @brief called when the window closes, before its context is destroyed
+	 */
 	virtual void close_ogl();
 	virtual void init_ogl() = 0;
 	virtual void draw_ogl() = 0;
@@ -22,6 +22,7 @@
 #include "mesh.h"
 #include "gl_eigen.h"
 #include <iostream>
+#include <algorithm>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/mesh.h>
@@ -58,14 +59,27 @@ void BoundingBox::add_point(const GLVec3& P)
 
 
 Mesh::Mesh(Mesh&& m):
-	vertices_(m.vertices_),
-	normals_(m.normals_),
-	tex_coords_(m.tex_coords_),
-	tri_indices(m.tri_indices),
-	line_indices(m.line_indices),
+	vertices_(std::move(m.vertices_)),
+	normals_(std::move(m.normals_)),
+	tex_coords_(std::move(m.tex_coords_)),
+	colors_(std::move(m.colors_)),
+	tri_indices(std::move(m.tri_indices)),
+	line_indices(std::move(m.line_indices)),
 	bb_(m.bb_)
 {}
 
+Mesh& Mesh::operator=(Mesh&& m)
+{
+	vertices_ = std::move(m.vertices_);
+	normals_ = std::move(m.normals_);
+	tex_coords_ = std::move(m.tex_coords_);
+	colors_ = std::move(m.colors_);
+	tri_indices = std::move(m.tri_indices);
+	line_indices = std::move(m.line_indices);
+	bb_ = m.bb_;
+	return *this;
+}
+
 
 
 void Mesh::compute_normals()
@@ -90,14 +104,66 @@ void Mesh::compute_normals()
 }
 
 
-SP_MeshRenderer Mesh::renderer(GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col) const
+GLuint Mesh::interleave(std::vector<GLfloat>& buffer, bool with_norm, bool with_tc, bool with_col) const
+{
+	const std::size_t nbv = vertices_.size();
+	with_norm = with_norm && (normals_.size() == nbv);
+	with_tc = with_tc && (tex_coords_.size() == nbv);
+	with_col = with_col && (colors_.size() == nbv);
+
+	GLuint stride = 3u + (with_norm ? 3u : 0u) + (with_tc ? 2u : 0u) + (with_col ? 3u : 0u);
+	buffer.resize(nbv*stride);
+
+	GLfloat* ptr = buffer.data();
+	for (std::size_t i=0; i<nbv; ++i)
+	{
+		ptr = std::copy(vertices_[i].data(), vertices_[i].data()+3, ptr);
+		if (with_norm)
+			ptr = std::copy(normals_[i].data(), normals_[i].data()+3, ptr);
+		if (with_tc)
+			ptr = std::copy(tex_coords_[i].data(), tex_coords_[i].data()+2, ptr);
+		if (with_col)
+			ptr = std::copy(colors_[i].data(), colors_[i].data()+3, ptr);
+	}
+	return stride;
+}
+
+SP_MeshRenderer Mesh::renderer(GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col, bool interleaved) const
 {
-    return std::make_shared<MeshRenderer>(*this,att_pos,att_norm,att_tc,att_col);
+    return std::make_shared<MeshRenderer>(*this,att_pos,att_norm,att_tc,att_col,interleaved);
 }
 
-MeshRenderer::MeshRenderer(const Mesh& m, GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col):
+MeshRenderer::MeshRenderer(const Mesh& m, GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col, bool interleaved):
 	bb_(m.bb_)
 {
+	ebo_triangles_.init(m.tri_indices);
+	ebo_lines_.init(m.line_indices);
+
+	if (interleaved)
+	{
+		// one buffer, one upload: attributes are packed in the order used by Mesh::interleave
+		const std::size_t nbv = m.vertices_.size();
+		bool with_norm = (att_norm>0) && (m.normals_.size() == nbv);
+		bool with_tc = (att_tc>0) && (m.tex_coords_.size() == nbv);
+		bool with_col = (att_col>0) && (m.colors_.size() == nbv);
+
+		std::vector<GLfloat> buffer;
+		GLuint stride = m.interleave(buffer, with_norm, with_tc, with_col);
+		auto vbo = VBO::create(buffer, stride);
+
+		std::vector<std::tuple<GLint,GLint>> att_dim;
+		att_dim.reserve(4);
+		att_dim.emplace_back(att_pos>0 ? att_pos : -1, 3);
+		if (with_norm)
+			att_dim.emplace_back(att_norm, 3);
+		if (with_tc)
+			att_dim.emplace_back(att_tc, 2);
+		if (with_col)
+			att_dim.emplace_back(att_col, 3);
+		vao_ = new VAO(vbo, att_dim);
+		return;
+	}
+
     std::vector<std::tuple<GLint,std::shared_ptr<VBO>>> params;
 	if( att_pos>0)
 	{
@@ -123,8 +189,6 @@ MeshRenderer::MeshRenderer(const Mesh& m, GLint att_pos, GLint att_norm, GLint a
 
 
 	vao_ = new VAO(params);
-	ebo_triangles_.init(m.tri_indices);
-	ebo_lines_.init(m.line_indices);
 }
 
 
@@ -666,6 +730,7 @@ std::vector<Mesh> Mesh::load(const std::string& mesh_filename)
      std::string dir = mesh_filename.substr(0, mesh_filename.find_last_of('/'));
 
      std::vector<Mesh> meshes;
+	 meshes.reserve(scene->mNumMeshes);
 	 Mesh::ai_process_node(meshes, scene->mRootNode, scene);
 
      std::cout  << "RETURN MESHES "<< std::endl;
@@ -92,7 +92,9 @@ public:
 
 	Mesh(::aiMesh* aimesh);
 	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
 	Mesh(Mesh&& m);
+	Mesh& operator=(Mesh&& m);
 
 	void compute_normals();
 	void linear_loop();
@@ -104,7 +106,15 @@ public:
 
 	inline const BoundingBox& BB() const { return bb_;}
 
-	SP_MeshRenderer renderer(GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col) const;
+	/**
+	 * @brief interleave attributes in one buffer (position, normal, tex coord, color)
+	 * @param buffer destination, allocated once
+	 * @param with_norm / with_tc / with_col attributes to append after position (ignored if not filled)
+	 * @return stride in floats of a vertex
+	 */
+	GLuint interleave(std::vector<GLfloat>& buffer, bool with_norm, bool with_tc, bool with_col) const;
+
+	SP_MeshRenderer renderer(GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col, bool interleaved = false) const;
 
 	static Mesh CubePosOnly();
 	static Mesh Cube();
@@ -141,7 +151,7 @@ protected:
 	EBO ebo_lines_;
 	BoundingBox bb_;
 public:
-	MeshRenderer(const Mesh& m, GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col);
+	MeshRenderer(const Mesh& m, GLint att_pos, GLint att_norm, GLint att_tc, GLint att_col, bool interleaved = false);
 	~MeshRenderer();
 	void draw(GLenum prim);
 };
@@ -45,7 +45,15 @@
 #include "shader_program.h"
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
 #include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 #pragma warning( disable : 4244 4018)
 
@@ -232,8 +240,178 @@ void ShaderProgram::location_analyser(std::string& src)
 
 }
 
+std::string ShaderProgram::binary_cache_dir_;
+
+namespace
+{
+
+const char binary_cache_magic[8] = {'E','Z','P','R','O','G','B','1'};
+
+inline void fnv1a(uint64_t& h, const void* data, std::size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		h ^= bytes[i];
+		h *= 0x100000001b3ull;
+	}
+}
+
+inline void fnv1a(uint64_t& h, const char* str)
+{
+	// keep the terminating 0 so that concatenations of strings do not collide
+	fnv1a(h, str, std::strlen(str) + 1);
+}
+
+bool make_dirs(const std::string& dir)
+{
+	for (std::size_t pos = dir.find_first_of("/\\", 1); ; pos = dir.find_first_of("/\\", pos + 1))
+	{
+		const std::string sub = dir.substr(0, pos);
+#ifdef _WIN32
+		_mkdir(sub.c_str());
+#else
+		mkdir(sub.c_str(), 0755);
+#endif
+		if (pos == std::string::npos)
+			break;
+	}
+	struct stat st;
+	return stat(dir.c_str(), &st) == 0;
+}
+
+/**
+ * @brief cache file of a program: hash of the sources, transform feedback outputs and driver strings
+ */
+std::string binary_cache_file(const std::string& dir, const std::vector<std::pair<GLenum,const std::string&>>& sources, const std::vector<char*>& tf_outs)
+{
+	GLint nb_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nb_formats);
+	if (dir.empty() || nb_formats == 0)
+		return "";
+
+	uint64_t h = 0xcbf29ce484222325ull;
+	for (GLenum e : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION})
+	{
+		const GLubyte* str = glGetString(e);
+		fnv1a(h, str ? reinterpret_cast<const char*>(str) : "");
+	}
+	for (const auto& sh: sources)
+	{
+		fnv1a(h, &sh.first, sizeof(sh.first));
+		fnv1a(h, sh.second.c_str());
+	}
+	for (const char* out: tf_outs)
+		fnv1a(h, out);
+
+	std::ostringstream file;
+	file << dir << '/' << std::hex << std::setw(16) << std::setfill('0') << h << ".bin";
+	return file.str();
+}
+
+bool load_program_binary(GLuint prg, const std::string& file)
+{
+	std::ifstream fs(file, std::ios::binary);
+	if (!fs.good())
+		return false;
+
+	char magic[8];
+	GLenum format;
+	uint32_t length;
+	fs.read(magic, sizeof(magic));
+	fs.read(reinterpret_cast<char*>(&format), sizeof(format));
+	fs.read(reinterpret_cast<char*>(&length), sizeof(length));
+	if (!fs.good() || std::memcmp(magic, binary_cache_magic, sizeof(magic)) != 0)
+		return false;
+
+	std::vector<char> binary(length);
+	fs.read(binary.data(), length);
+	if (!fs.good())
+		return false;
+
+	// the driver refuses binaries of another version, the program is then compiled again
+	glProgramBinary(prg, format, binary.data(), GLsizei(length));
+	GLint status = GL_FALSE;
+	glGetProgramiv(prg, GL_LINK_STATUS, &status);
+	return status == GL_TRUE;
+}
+
+void save_program_binary(GLuint prg, const std::string& dir, const std::string& file)
+{
+	GLint length = 0;
+	glGetProgramiv(prg, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0 || !make_dirs(dir))
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(prg, length, nullptr, &format, binary.data());
+	const uint32_t size = uint32_t(length);
+
+	// written aside then renamed, a concurrent launch never reads a partial file
+	const std::string tmp = file + ".tmp";
+	{
+		std::ofstream fs(tmp, std::ios::binary | std::ios::trunc);
+		fs.write(binary_cache_magic, sizeof(binary_cache_magic));
+		fs.write(reinterpret_cast<const char*>(&format), sizeof(format));
+		fs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		fs.write(binary.data(), length);
+		if (!fs.good())
+		{
+			std::remove(tmp.c_str());
+			return;
+		}
+	}
+	if (std::rename(tmp.c_str(), file.c_str()) != 0)
+		std::remove(tmp.c_str());
+}
+
+} // namespace
+
+void ShaderProgram::set_binary_cache(const std::string& dir)
+{
+	binary_cache_dir_ = dir;
+	while (binary_cache_dir_.size() > 1 && (binary_cache_dir_.back() == '/' || binary_cache_dir_.back() == '\\'))
+		binary_cache_dir_.pop_back();
+}
+
+std::string ShaderProgram::specialize(const std::string& src, const std::vector<std::string>& defines)
+{
+	if (defines.empty())
+		return src;
+
+	std::size_t insert = 0;
+	const std::size_t version = src.find("#version");
+	if (version != std::string::npos)
+	{
+		insert = src.find('\n', version);
+		insert = (insert == std::string::npos) ? src.size() : insert + 1;
+	}
+	const auto line = std::count(src.begin(), src.begin() + insert, '\n') + 1;
+
+	std::string result = src.substr(0, insert);
+	if (!result.empty() && result.back() != '\n')
+		result += '\n';
+	for (const auto& def: defines)
+		result += "#define " + def + "\n";
+	result += "#line " + std::to_string(line) + "\n";
+	result += src.substr(insert);
+	return result;
+}
+
+void ShaderProgram::translate_locations()
+{
+	for (const auto& p: ulocations)
+	{
+		auto uni = glGetUniformLocation(this->id_,p.first.c_str());
+		this->utranslat[p.second] = uni;
+		std::cout << "Uniform "<<p.first<< " GL: "<< uni<< " User: "<<p.second<<std::endl;
+	}
+}
+
 ShaderProgram::ShaderProgram(const std::vector<std::pair<GLenum,const std::string&>> sources,  const std::string& name, const std::vector<char*> tf_outs) :
-	name_(name)
+	name_(name),
+	from_binary_(false)
 {
 	utranslat.resize(256);
 	for (int i=0;i<256;++i)
@@ -241,6 +419,22 @@ ShaderProgram::ShaderProgram(const std::vector<std::pair<GLenum,const std::strin
 
 
 	id_ = glCreateProgram();
+
+	const std::string cache_file = binary_cache_file(binary_cache_dir_, sources, tf_outs);
+	if (!cache_file.empty() && load_program_binary(id_, cache_file))
+	{
+		from_binary_ = true;
+		if (!Uniform_Explicit_Location_Support)
+		{
+			for (const auto& sh: sources)
+			{
+				std::string src = sh.second;
+				location_analyser(src);
+			}
+			translate_locations();
+		}
+		return;
+	}
 ////V1
 
 	if (Uniform_Explicit_Location_Support)
@@ -271,6 +465,11 @@ ShaderProgram::ShaderProgram(const std::vector<std::pair<GLenum,const std::strin
 		glTransformFeedbackVaryings(id_, GLsizei(tf_outs.size()), tf_outs.data(), GL_SEPARATE_ATTRIBS);
 	}
 
+	if (!cache_file.empty())
+	{
+		glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	glLinkProgram(id_);
 
 	for (auto sh: shaders_)
@@ -280,12 +479,7 @@ ShaderProgram::ShaderProgram(const std::vector<std::pair<GLenum,const std::strin
 
 	if (!Uniform_Explicit_Location_Support)
 	{
-		for (const auto& p: ulocations)
-		{
-			auto uni = glGetUniformLocation(this->id_,p.first.c_str());
-			this->utranslat[p.second] = uni;
-			std::cout << "Uniform "<<p.first<< " GL: "<< uni<< " User: "<<p.second<<std::endl;
-		}
+		translate_locations();
 	}
 
 	int infologLength = 0;
@@ -298,6 +492,13 @@ ShaderProgram::ShaderProgram(const std::vector<std::pair<GLenum,const std::strin
 		std::cerr << "Link message :" << name << " :" << std::endl<< infoLog << std::endl;
 		delete[] infoLog;
 	}
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(id_, GL_LINK_STATUS, &status);
+	if (!cache_file.empty() && status == GL_TRUE)
+	{
+		save_program_binary(id_, binary_cache_dir_, cache_file);
+	}
 }
 
 
@@ -316,6 +517,15 @@ SP_ShaderProgram ShaderProgram::create(const std::vector<std::pair<GLenum,const
 }
 
 
+void ShaderProgram::swap(ShaderProgram& other)
+{
+	std::swap(id_, other.id_);
+	std::swap(shaders_, other.shaders_);
+	std::swap(ulocations, other.ulocations);
+	std::swap(utranslat, other.utranslat);
+	std::swap(from_binary_, other.from_binary_);
+}
+
 
 
 ShaderProgram::~ShaderProgram()
@@ -81,10 +81,31 @@ protected:
 	std::vector<Shader*> shaders_;
 	std::map<std::string,int> ulocations;
 	std::vector<int> utranslat;
+	bool from_binary_;
+
+	static std::string binary_cache_dir_;
+
+	void translate_locations();
 
 public:
 	static ShaderProgram* current_binded_;
 
+	/**
+	 * @brief enable the program binary cache: linked programs are saved in dir (created if needed)
+	 * keyed by a hash of their sources and of the driver strings, and reloaded with glProgramBinary
+	 * instead of being compiled again. Empty dir to disable (default).
+	 * @param dir cache directory
+	 */
+	static void set_binary_cache(const std::string& dir);
+
+	/**
+	 * @brief insert #define lines after the #version line of a source, to compile variants of a shader
+	 * specialized on compile time constants. A #line directive keeps the line numbers of the errors.
+	 * @param src shader source
+	 * @param defines "NAME" or "NAME value" each
+	 */
+	static std::string specialize(const std::string& src, const std::vector<std::string>& defines);
+
 	ShaderProgram(const std::vector<std::pair<GLenum,const std::string&>> sources,  const std::string& name, const std::vector<char*> tf_outs = { });
 
 	ShaderProgram(const ShaderProgram&) = delete;
@@ -95,7 +116,15 @@ public:
 
 	static SP_ShaderProgram create(const std::vector<std::pair<GLenum,const std::string&>> sources,  const std::string& name);
 
+	/**
+	 * @brief exchange the GL program and its uniform locations with other, to install a program
+	 * rebuilt from new sources while keeping the SP_ShaderProgram shared by its users
+	 * @param other program to exchange with (keeps the previous one)
+	 */
+	void swap(ShaderProgram& other);
+
 	inline GLuint id() const		{ return id_; }
+	inline bool from_binary_cache() const { return from_binary_; }
 	inline static void unbind()		{ glUseProgram(0); }
 	inline void bind()				{ glUseProgram(id_); current_binded_ = this;}
 	inline GLint uniform_location(const GLchar* str) const
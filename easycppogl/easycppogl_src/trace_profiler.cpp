@@ -0,0 +1,257 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#include "trace_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace EZCOGL
+{
+
+const std::size_t TraceProfiler::EVENTS_PER_THREAD;
+const std::size_t TraceProfiler::MAX_EXITED_THREADS;
+
+namespace
+{
+
+struct TraceEvent
+{
+	const char* name;
+	std::uint64_t begin;
+	std::uint64_t end;
+};
+
+// only its thread writes in a buffer, the lock is taken by the dumps
+struct ThreadBuffer
+{
+	std::mutex mutex;
+	std::vector<TraceEvent> events;
+	std::size_t next;
+	std::uint32_t id;
+	std::string name;
+	bool exited;
+};
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::uint32_t next_id;
+	std::atomic<bool> enabled;
+	// timestamps of the traces are relative to the first use of the profiler
+	std::uint64_t origin;
+
+	Registry() :
+		next_id(1),
+		enabled(true),
+		origin(TraceProfiler::now_ns())
+	{}
+};
+
+Registry& registry()
+{
+	static Registry r;
+	return r;
+}
+
+void retire(const std::shared_ptr<ThreadBuffer>& buffer)
+{
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	{
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		buffer->exited = true;
+	}
+
+	std::size_t exited = std::size_t(std::count_if(r.buffers.begin(), r.buffers.end(),
+		[](const std::shared_ptr<ThreadBuffer>& b) { return b->exited; }));
+	for (auto b = r.buffers.begin(); b != r.buffers.end() && exited > TraceProfiler::MAX_EXITED_THREADS;)
+	{
+		if ((*b)->exited)
+		{
+			b = r.buffers.erase(b);
+			--exited;
+		}
+		else
+			++b;
+	}
+}
+
+struct ThreadHolder
+{
+	std::shared_ptr<ThreadBuffer> buffer;
+
+	~ThreadHolder()
+	{
+		if (buffer)
+			retire(buffer);
+	}
+};
+
+ThreadBuffer& thread_buffer()
+{
+	thread_local ThreadHolder holder;
+	if (!holder.buffer)
+	{
+		auto buffer = std::make_shared<ThreadBuffer>();
+		buffer->next = 0;
+		buffer->exited = false;
+
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		buffer->id = r.next_id++;
+		r.buffers.push_back(buffer);
+		holder.buffer = buffer;
+	}
+	return *holder.buffer;
+}
+
+void write_string(std::ostream& out, const std::string& s)
+{
+	out << '"';
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+			out << ' ';
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+}
+
+void TraceProfiler::set_enabled(bool enabled)
+{
+	registry().enabled = enabled;
+}
+
+bool TraceProfiler::enabled()
+{
+	return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void TraceProfiler::set_thread_name(const std::string& name)
+{
+	ThreadBuffer& buffer = thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = name;
+}
+
+void TraceProfiler::clear()
+{
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	for (auto& b : r.buffers)
+	{
+		std::lock_guard<std::mutex> buffer_lock(b->mutex);
+		b->events.clear();
+		b->next = 0;
+	}
+}
+
+std::uint64_t TraceProfiler::now_ns()
+{
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void TraceProfiler::record(const char* name, std::uint64_t begin_ns, std::uint64_t end_ns)
+{
+	ThreadBuffer& buffer = thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if (buffer.events.size() < EVENTS_PER_THREAD)
+		buffer.events.push_back(TraceEvent{name, begin_ns, end_ns});
+	else
+	{
+		buffer.events[buffer.next] = TraceEvent{name, begin_ns, end_ns};
+		buffer.next = (buffer.next + 1) % EVENTS_PER_THREAD;
+	}
+}
+
+bool TraceProfiler::write_chrome_trace(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "Unable to write '" << path << "'" << std::endl;
+		return false;
+	}
+
+	Registry& r = registry();
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(r.mutex);
+		buffers = r.buffers;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	std::vector<TraceEvent> events;
+	for (const auto& b : buffers)
+	{
+		std::string name;
+		{
+			std::lock_guard<std::mutex> lock(b->mutex);
+			events = b->events;
+			name = b->name;
+		}
+		if (name.empty())
+			name = "thread " + std::to_string(b->id);
+
+		file << (first ? "\n" : ",\n")
+			 << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id << ",\"args\":{\"name\":";
+		write_string(file, name);
+		file << "}}";
+		first = false;
+
+		for (const auto& e : events)
+		{
+			file << ",\n{\"name\":";
+			write_string(file, e.name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->id
+				 << ",\"ts\":" << double(e.begin - std::min(e.begin, r.origin)) / 1e3
+				 << ",\"dur\":" << double(e.end - e.begin) / 1e3 << "}";
+		}
+	}
+	file << "\n]}\n";
+
+	if (!file)
+	{
+		std::cerr << "Unable to write '" << path << "'" << std::endl;
+		return false;
+	}
+	std::cout << "Trace written to '" << path << "'" << std::endl;
+	return true;
+}
+
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************
+* EasyCppOGL:   Copyright (C) 2019,                                            *
+* Sylvain Thery, IGG Group, ICube, University of Strasbourg, France            *
+*                                                                              *
+* This library is free software; you can redistribute it and/or modify it      *
+* under the terms of the GNU Lesser General Public License as published by the *
+* Free Software Foundation; either version 2.1 of the License, or (at your     *
+* option) any later version.                                                   *
+*                                                                              *
+* This library is distributed in the hope that it will be useful, but WITHOUT  *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or        *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License  *
+* for more details.                                                            *
+*                                                                              *
+* You should have received a copy of the GNU Lesser General Public License     *
+* along with this library; if not, write to the Free Software Foundation,      *
+* Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA.           *
+*                                                                              *
+* Contact information: thery@unistra.fr                                        *
+*******************************************************************************/
+
+#ifndef EASY_CPP_OGL_TRACE_PROFILER_H_
+#define EASY_CPP_OGL_TRACE_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+
+namespace EZCOGL
+{
+
+/**
+ * @brief scoped zone profiler writing Chrome trace files (chrome://tracing, Perfetto).
+ *
+ * Each thread records its zones in its own ring buffer holding its last EVENTS_PER_THREAD
+ * zones, allocated as it fills, so recording never waits for other threads. The buffers
+ * of exited threads are kept for the next dump, the oldest dropped beyond
+ * MAX_EXITED_THREADS. Timestamps are taken from std::chrono::steady_clock.
+ */
+class TraceProfiler
+{
+public:
+	static const std::size_t EVENTS_PER_THREAD = 1 << 16;
+	static const std::size_t MAX_EXITED_THREADS = 64;
+
+	/**
+	 * @brief recording is on by default, zones started while it is off are not recorded
+	 */
+	static void set_enabled(bool enabled);
+	static bool enabled();
+
+	/**
+	 * @brief name of the calling thread in the traces
+	 */
+	static void set_thread_name(const std::string& name);
+
+	/**
+	 * @brief forget the recorded zones of every thread
+	 */
+	static void clear();
+
+	/**
+	 * @brief write the recorded zones of every thread in the Chrome trace event format
+	 */
+	static bool write_chrome_trace(const std::string& path);
+
+	static std::uint64_t now_ns();
+
+	/**
+	 * @brief record a zone of the calling thread, name must outlive the profiler (literal)
+	 */
+	static void record(const char* name, std::uint64_t begin_ns, std::uint64_t end_ns);
+};
+
+/**
+ * @brief RAII zone, e.g. TraceZone zone("upload");
+ */
+class TraceZone
+{
+	const char* name_;
+	std::uint64_t begin_;
+
+public:
+	inline explicit TraceZone(const char* name) :
+		name_(name),
+		begin_(TraceProfiler::enabled() ? TraceProfiler::now_ns() : 0)
+	{}
+
+	inline ~TraceZone()
+	{
+		if (begin_ != 0)
+			TraceProfiler::record(name_, begin_, TraceProfiler::now_ns());
+	}
+
+	TraceZone(const TraceZone&) = delete;
+	TraceZone& operator=(const TraceZone&) = delete;
+};
+
+}
+#endif
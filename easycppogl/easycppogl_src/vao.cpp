@@ -123,6 +123,54 @@ VAO::VAO(const std::vector<std::tuple<GLint,std::shared_ptr<VBO>,GLint,GLint,GLi
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+VAO::VAO(const SP_VBO& vbo, const std::vector<std::tuple<GLint,GLint>>& att_dim)
+{
+	glGenVertexArrays(1, &id_);
+	nb_ = GLuint(vbo->length());
+	if (att_dim.empty())
+		return;
+
+	GLsizei stride = GLsizei(vbo->vector_dimension()*sizeof(float));
+	std::size_t offset = 0;
+	glBindVertexArray(id_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo->id());
+	for (const auto& a: att_dim)
+	{
+		if (std::get<0>(a) >= 0) // negative attribute id: unused floats, only skipped
+		{
+			GLuint vid = GLuint(std::get<0>(a));
+			glEnableVertexAttribArray(vid);
+			glVertexAttribPointer(vid, std::get<1>(a), GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offset*sizeof(float)));
+		}
+		offset += std::size_t(std::get<1>(a));
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+VAO::VAO(const SP_VBO& vbo, GLuint nb_vertices, const std::vector<VertexAttribute>& atts):
+	nb_(nb_vertices)
+{
+	glGenVertexArrays(1, &id_);
+	if (atts.empty())
+		return;
+
+	glBindVertexArray(id_);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo->id());
+	for (const auto& a: atts)
+	{
+		GLuint vid = GLuint(a.location);
+		glEnableVertexAttribArray(vid);
+		bool integer = (a.type != GL_FLOAT) && (a.type != GL_HALF_FLOAT) && (a.type != GL_DOUBLE);
+		if (integer && !a.normalized)
+			glVertexAttribIPointer(vid, a.size, a.type, a.stride, reinterpret_cast<void*>(std::size_t(a.offset)));
+		else
+			glVertexAttribPointer(vid, a.size, a.type, a.normalized, a.stride, reinterpret_cast<void*>(std::size_t(a.offset)));
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 SP_VAO VAO::create_interleaved(const std::vector<std::tuple<GLint,SP_VBO>>& att_vbo)
 {
 	GLint stride=0;
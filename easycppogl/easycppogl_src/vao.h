@@ -31,6 +31,20 @@ namespace EZCOGL
 class VAO;
 using SP_VAO = std::shared_ptr<VAO>;
 
+/**
+ * @brief one attribute of a VBO with explicit type (offset and stride in bytes)
+ * integer types that are not normalized are bound with glVertexAttribIPointer
+ */
+struct VertexAttribute
+{
+	GLint location;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLsizei stride;
+	GLuint offset;
+};
+
 class VAO
 {
 protected:
@@ -46,6 +60,10 @@ public:
 
 	VAO(const std::vector<std::tuple<GLint,SP_VBO,GLint,GLint,GLint>>& att_vbo);
 
+	VAO(const SP_VBO& vbo, const std::vector<std::tuple<GLint,GLint>>& att_dim);
+
+	VAO(const SP_VBO& vbo, GLuint nb_vertices, const std::vector<VertexAttribute>& atts);
+
 
 	VAO(const VAO&) = delete ;
 
@@ -95,6 +113,29 @@ public:
 	 */
 	static SP_VAO create_interleaved(const std::vector<std::tuple<GLint,SP_VBO,GLint>>& att_vbo);
 
+	/**
+	 * @brief create VAO for a single interleaved VBO (vector dimension of VBO is the stride)
+	 * @param vbo buffer containing all attributes of a vertex side by side
+	 * @param att_dim couple attribute id (negative to skip), number of floats of attribute (in buffer order)
+	 * @return
+	 */
+	inline static SP_VAO create_interleaved(const SP_VBO& vbo, const std::vector<std::tuple<GLint,GLint>>& att_dim)
+	{
+		return std::make_shared<VAO>(vbo,att_dim);
+	}
+
+	/**
+	 * @brief create VAO with typed attributes all sourced from one VBO (interleaved or by blocks)
+	 * @param vbo buffer
+	 * @param nb_vertices number of vertices stored in buffer
+	 * @param atts attributes description
+	 * @return
+	 */
+	inline static SP_VAO create(const SP_VBO& vbo, GLuint nb_vertices, const std::vector<VertexAttribute>& atts)
+	{
+		return std::make_shared<VAO>(vbo,nb_vertices,atts);
+	}
+
 
 	inline void bind()
 	{
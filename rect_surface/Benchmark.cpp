@@ -0,0 +1,236 @@
+#include "Benchmark.hpp"
+#include "Viewer.hpp"
+
+#include "RandomNet.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    // the camera turns once around the net during the frames of a level,
+    // looking at it from above and moving closer and away twice
+    constexpr double ORBIT_TILT = -1.;
+    constexpr double ORBIT_DOLLY = 0.4;
+    constexpr double PI = 3.14159265358979323846;
+
+    void orbit(Camera& camera, std::size_t frame, std::size_t frames) {
+        const double angle = 2. * PI * static_cast<double>(frame)
+                             / static_cast<double>(std::max<std::size_t>(frames, 1));
+        camera.reset();
+        camera.frame_ = Eigen::Translation3d(0., 0., ORBIT_DOLLY * camera.scene_radius()
+                                                     * std::sin(2. * angle))
+                        * Eigen::AngleAxisd(ORBIT_TILT, Eigen::Vector3d::UnitX())
+                        * Eigen::AngleAxisd(angle, Eigen::Vector3d::UnitZ());
+    }
+
+    bool hasPipelineStatistics() {
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 6)) {
+            return true;
+        }
+
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; ++i) {
+            const auto* name = reinterpret_cast<const char*>(
+                    glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i))
+            );
+            if (std::string(name) == "GL_ARB_pipeline_statistics_query") {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    double mean(const std::vector<double>& values) {
+        double sum = 0.;
+        for (const double value : values) {
+            sum += value;
+        }
+        return values.empty() ? 0. : sum / static_cast<double>(values.size());
+    }
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.;
+    }
+    const auto rank = static_cast<std::size_t>(
+            std::ceil(fraction * static_cast<double>(values.size()))
+    );
+    const auto nth = values.begin() + static_cast<long>(
+            std::min(std::max<std::size_t>(rank, 1), values.size()) - 1
+    );
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+void printBenchmark(std::ostream& out, const BenchmarkOptions& options,
+                    const std::vector<BenchmarkResult>& results) {
+    out << options.patchCount << " patches, " << options.frames << " frames of "
+        << options.width << "x" << options.height << std::endl;
+    out << std::setw(8) << "level"
+        << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+        << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+        << std::setw(10) << "GPU ms" << std::setw(16) << "TES invocations"
+        << std::endl;
+
+    out << std::fixed;
+    for (const auto& result : results) {
+        out << std::setprecision(1) << std::setw(8) << result.level
+            << std::setprecision(3)
+            << std::setw(10) << result.frameP50Ms << std::setw(10) << result.frameP90Ms
+            << std::setw(10) << result.frameP99Ms << std::setw(10) << result.frameMaxMs
+            << std::setw(10) << result.gpuMs
+            << std::setprecision(0) << std::setw(16) << result.tesInvocations
+            << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+bool writeBenchmarkJson(const std::string& path, const BenchmarkOptions& options,
+                        const std::string& renderer,
+                        const std::vector<BenchmarkResult>& results) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Unable to write '" << path << "'" << std::endl;
+        return false;
+    }
+
+    std::string escaped;
+    for (const char c : renderer) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+
+    file << "{\n"
+         << "  \"renderer\": \"" << escaped << "\",\n"
+         << "  \"patches\": " << options.patchCount << ",\n"
+         << "  \"seed\": " << options.seed << ",\n"
+         << "  \"frames\": " << options.frames << ",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"levels\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "    {\"level\": " << result.level
+             << ", \"frame_p50_ms\": " << result.frameP50Ms
+             << ", \"frame_p90_ms\": " << result.frameP90Ms
+             << ", \"frame_p99_ms\": " << result.frameP99Ms
+             << ", \"frame_max_ms\": " << result.frameMaxMs
+             << ", \"gpu_ms\": " << result.gpuMs
+             << ", \"tes_invocations\": " << result.tesInvocations << "}";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool Viewer::runBenchmark(const BenchmarkOptions& options,
+                          std::vector<BenchmarkResult>& results) {
+    results.clear();
+    if (options.frames == 0 || options.width <= 0 || options.height <= 0) {
+        return false;
+    }
+
+    init_ogl();
+
+    // the scene of init_ogl is replaced by the random net
+    stream.stop();
+    pool.clear();
+    generateRandomNet(pool, options.patchCount, options.seed);
+    pool.upload();
+    modelPath.clear();
+    set_scene_radius(3.0);
+
+    vp_w_ = options.width;
+    vp_h_ = options.height;
+    cam_.set_aspect_ratio(static_cast<double>(vp_w_) / vp_h_);
+    resize_ogl(vp_w_, vp_h_);
+    FBO::initial_viewport_ = {0, 0, vp_w_, vp_h_};
+
+    // the window is not shown, everything is drawn in framebuffer objects
+    auto colorTexture = Texture2D::create({GL_NEAREST});
+    colorTexture->init(GL_RGBA8);
+    auto target = FBO_DepthTexture::create({colorTexture});
+    target->resize(vp_w_, vp_h_);
+
+    const bool statistics = hasPipelineStatistics();
+    GLuint queries[2];
+    glGenQueries(2, queries);
+
+    std::vector<double> frameMs;
+    std::vector<double> gpuMs;
+    std::vector<double> tesInvocations;
+    for (const float level : options.levels) {
+        tesselationLevel = level;
+        frameMs.clear();
+        gpuMs.clear();
+        tesInvocations.clear();
+
+        for (std::size_t frame = 0; frame < options.warmupFrames + options.frames; ++frame) {
+            const bool measured = frame >= options.warmupFrames;
+            orbit(cam_, measured ? frame - options.warmupFrames : 0, options.frames);
+            frame_arena_.reset();
+            frame_stats_.begin_frame();
+
+            const bool occlusion = occlusionCulling && sceneFbo
+                                   && useGpuCommands && indirectDraws.available();
+            const double start = glfwGetTime();
+            glBeginQuery(GL_TIME_ELAPSED, queries[0]);
+            if (statistics) {
+                glBeginQuery(GL_TESS_EVALUATION_SHADER_INVOCATIONS, queries[1]);
+            }
+
+            if (occlusion) {
+                sceneFbo->bind();
+            } else {
+                target->bind();
+            }
+            drawScene(occlusion);
+            FBO::unbind();
+            frame_stats_.end_frame();
+
+            glEndQuery(GL_TIME_ELAPSED);
+            if (statistics) {
+                glEndQuery(GL_TESS_EVALUATION_SHADER_INVOCATIONS);
+            }
+            glFinish();
+            const double end = glfwGetTime();
+            if (!measured) {
+                continue;
+            }
+
+            GLuint64 value = 0;
+            frameMs.push_back((end - start) * 1000.);
+            glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &value);
+            gpuMs.push_back(static_cast<double>(value) / 1e6);
+            if (statistics) {
+                glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &value);
+                tesInvocations.push_back(static_cast<double>(value));
+            }
+        }
+
+        results.push_back({
+            level, options.frames,
+            percentile(frameMs, 0.5), percentile(frameMs, 0.9),
+            percentile(frameMs, 0.99), percentile(frameMs, 1.),
+            mean(gpuMs), statistics ? mean(tesInvocations) : -1.
+        });
+    }
+
+    glDeleteQueries(2, queries);
+    frame_stats_.release();
+    close_ogl();
+    return true;
+}
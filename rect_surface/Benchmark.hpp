@@ -0,0 +1,59 @@
+#ifndef BEZIER_BENCHMARK_HPP
+#define BEZIER_BENCHMARK_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * Offscreen rendering benchmark of the surface viewer (see
+ * Viewer::runBenchmark): a random net of patchCount bicubic patches drawn
+ * frames times along a fixed orbit of the camera, once per tessellation
+ * level.
+ */
+struct BenchmarkOptions {
+    std::size_t patchCount = 1024;
+    unsigned seed = 0;
+    std::size_t frames = 200;
+    // frames drawn before the measures of each level (shader variants...)
+    std::size_t warmupFrames = 10;
+    std::vector<float> levels{1.f, 4.f, 16.f, 32.f};
+    int width = 1280;
+    int height = 720;
+};
+
+/**
+ * Measures of one tessellation level. The frame times are the CPU time of a
+ * frame, from its first command to the end of its execution (glFinish).
+ * Statistics the driver does not support are negative.
+ */
+struct BenchmarkResult {
+    float level;
+    std::size_t frames;
+    double frameP50Ms;
+    double frameP90Ms;
+    double frameP99Ms;
+    double frameMaxMs;
+    // means per frame
+    double gpuMs;
+    double tesInvocations;
+};
+
+/**
+ * Value below which lies the given fraction of the values (nearest rank),
+ * 0 when there are none.
+ */
+double percentile(std::vector<double> values, double fraction);
+
+void printBenchmark(std::ostream& out, const BenchmarkOptions& options,
+                    const std::vector<BenchmarkResult>& results);
+
+/**
+ * One object with the options, the renderer and a result per level.
+ */
+bool writeBenchmarkJson(const std::string& path, const BenchmarkOptions& options,
+                        const std::string& renderer,
+                        const std::vector<BenchmarkResult>& results);
+
+#endif //BEZIER_BENCHMARK_HPP
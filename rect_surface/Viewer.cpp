@@ -1,155 +1,497 @@
 #include "Viewer.hpp"
 
-#include <random>
+#include "ControlNetFile.hpp"
+#include "MeshExporter.hpp"
+#include "easycppogl_src/portable_file_dialogs.h"
 
-Viewer::Viewer() :
-        vao(nullptr),
-        dimU(0),
-        dimV(0),
-        drawMode(DrawMode::Fill),
-        tesselationLevel(1),
-        color{1., 0., 0., 1.},
-        pointsSize(10) {
-}
+#include <cmath>
+
+namespace {
+    // patches larger than this use the generic shader (see tessEval.glsl)
+    constexpr GLuint MAX_SPECIALIZED_CP_U = 8;
+    constexpr GLuint MAX_SPECIALIZED_CP_V = 8;
+    constexpr GLuint MAX_SPECIALIZED_CP = 32;
+
+    // how far from a control point, in pixels, a click selects it
+    constexpr float PICK_RADIUS = 8.f;
 
-void Viewer::init_bezierSurfaces_vao() {
-    constexpr size_t dimensionU = 6;
-    constexpr size_t dimensionV = 4;
+    // the spacing is in the upper bits of the keys, the patch size below
+    constexpr GLuint SPACING_SHIFT = 30;
 
-    std::vector<GLVec3> vertices;
-    vertices.reserve(dimensionU * dimensionV);
+    inline GLuint surfaceKey(GLuint countU, GLuint countV, TessSpacing spacing) {
+        return static_cast<GLuint>(spacing) << SPACING_SHIFT | countU << 16 | countV;
+    }
 
-    std::default_random_engine generator(
-            std::chrono::system_clock::now().time_since_epoch().count()
-    );
-    std::uniform_real_distribution<float> distribution(0.f, 2.f);
-    auto rand = std::bind(distribution, generator);
+    inline bool specialized(GLuint countU, GLuint countV) {
+        return countU <= MAX_SPECIALIZED_CP_U && countV <= MAX_SPECIALIZED_CP_V
+               && countU * countV <= MAX_SPECIALIZED_CP;
+    }
 
-    constexpr float offset = 1.f;
-    constexpr float uHalfSize = (offset * dimensionU) / 2.f;
-    constexpr float vHalfSize = (offset * dimensionV) / 2.f;
+    std::vector<std::string> surfaceDefines(GLuint key) {
+        const auto spacing = static_cast<TessSpacing>(key >> SPACING_SHIFT);
+        const GLuint countU = (key >> 16) & ((1u << (SPACING_SHIFT - 16)) - 1);
+        const GLuint countV = key & 0xffff;
 
-    for (size_t u = 0; u < dimensionU; ++u) {
-        for (size_t v = 0; v < dimensionV; ++v) {
-            vertices.emplace_back(
-                    (u * offset) - uHalfSize,
-                    (v * offset) - vHalfSize,
-                    rand()
-            );
+        std::vector<std::string> defines;
+        if (spacing != TessSpacing::Equal) {
+            defines.push_back("SPACING " + spacingQualifier(spacing));
+        }
+        if (specialized(countU, countV)) {
+            defines.push_back("CP_U_COUNT " + std::to_string(countU));
+            defines.push_back("CP_V_COUNT " + std::to_string(countV));
+            defines.push_back("CP_COUNT " + std::to_string(countU * countV));
         }
+        return defines;
     }
+}
+
+Viewer::Viewer(const std::string& modelPath, bool visible) :
+        GLViewer(visible),
+        bezierSurfaceShaders({
+            {GL_VERTEX_SHADER, "shaders/rational_vert.glsl"},
+            {GL_TESS_CONTROL_SHADER, "shaders/bezier_surface_rect/tessCont.glsl"},
+            {GL_TESS_EVALUATION_SHADER, "shaders/bezier_surface_rect/tessEval.glsl"},
+            {GL_FRAGMENT_SHADER, "shaders/basic_frag.glsl"}
+        }, "bezier_surface_rect", surfaceDefines),
+        lod(geometryBuffers),
+        modelPath(modelPath),
+        movingDepth(0.f),
+        drawMode(DrawMode::Fill),
+        useGpuCommands(true),
+        frustumCulling(true),
+        backPatchCulling(false),
+        occlusionCulling(true),
+        hiZMvp(GLMat4::Identity()),
+        hiZValid(false),
+        hiZGeneration(0),
+        useLod(false),
+        lodPixels(8.f),
+        tesselationLevel(1.f),
+        adaptiveTessellation(false),
+        spacing(TessSpacing::Equal),
+        segmentPixels(10.f),
+        color{1., 0., 0., 1.},
+        pointsSize(10) {
+}
 
-    auto vbo = VBO::create(vertices);
-    vao = VAO::create({{0, vbo}});
-    dimU = dimensionU;
-    dimV = dimensionV;
+void Viewer::loadModel(const std::string& path) {
+    stream.stop();
+    movingPoints.clear();
+    movingPatches.clear();
+    pool.clear();
+    pool.upload();
+
+    if (hasExtension(path, "cnet")) {
+        ControlNetFile::read(path, pool);
+    } else {
+        stream.start(path);
+    }
+    modelPath = path;
 }
 
 void Viewer::init_ogl() {
+    ShaderProgram::set_binary_cache(shaderCacheDirectory());
+
+    bezierSurfaceShaders.init(shaders);
+    // bicubic patches are most of the data, their variant is built upfront
+    bezierSurfaceShaders.get(surfaceKey(4, 4, spacing));
+    if (indirectDraws.init(shaders) && hiZ.init(shaders)) {
+        auto colorTexture = Texture2D::create({GL_NEAREST});
+        colorTexture->init(GL_RGBA8);
+        sceneFbo = FBO_DepthTexture::create({colorTexture});
+    }
+
+    controlPointsShaderProgram = shaders.create({
+        {GL_VERTEX_SHADER, "shaders/controlPoints_vert.glsl"},
+        {GL_FRAGMENT_SHADER, "shaders/vertexColor_frag.glsl"}
+    }, "control_points");
+    lodShaderProgram = shaders.create({
+        {GL_VERTEX_SHADER, "shaders/basicTransformable_vert.glsl"},
+        {GL_FRAGMENT_SHADER, "shaders/basic_frag.glsl"}
+    }, "patch_lod");
+
+    const std::string resourceDir = resourceOverrideDirectory();
+    if (!resourceDir.empty()) {
+        shaders.enableHotReload(resourceDir, create_shared_context());
+    }
 
-    bezierSurfaceShaderProgram = ShaderProgram::create({
-                                                               {
-                                                                       GL_VERTEX_SHADER,
-                                                                       readFile("shaders/basicTransformable_vert.glsl")
-                                                               }, {
-                                                                       GL_TESS_CONTROL_SHADER,
-                                                                       readFile("shaders/bezier_surface_rect/tessCont.glsl")
-                                                               }, {
-                                                                       GL_TESS_EVALUATION_SHADER,
-                                                                       readFile("shaders/bezier_surface_rect/tessEval.glsl")
-                                                               }, {
-                                                                       GL_FRAGMENT_SHADER,
-                                                                       readFile("shaders/basic_frag.glsl")
-                                                               }
-                                                       }, "");
-
-    transformablePointsShaderProgram = ShaderProgram::create({
-                                                                     {
-                                                                             GL_VERTEX_SHADER,
-                                                                             readFile("shaders/basicTransformable_vert.glsl")
-                                                                     }, {
-                                                                             GL_FRAGMENT_SHADER,
-                                                                             readFile("shaders/basic_frag.glsl")
-                                                                     }
-                                                             }, "");
-
-    init_bezierSurfaces_vao();
+    loadModel(modelPath.empty() ? RESOURCE_PATH + "models/rect_surface.obj"
+                                : modelPath);
 
     set_scene_center(GLVec3(0, 0, 0));
     set_scene_radius(3.0);
 
     glClearColor(0., 0., 0., 1.);
     glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void Viewer::close_ogl() {
+    // the programs are deleted while the window context still exists
+    shaders.shutdown();
+    bezierSurfaceShaders.release();
+    controlPointsShaderProgram.reset();
+    lodShaderProgram.reset();
+    indirectDraws.release();
+    hiZ.release();
+    sceneFbo.reset();
+}
+
+void Viewer::resize_ogl(int32_t w, int32_t h) {
+    if (sceneFbo) {
+        sceneFbo->resize(w, h);
+    }
 }
 
 void Viewer::draw_ogl() {
+    // the scene is rendered offscreen to keep its depth for the next frame
+    const bool occlusion = occlusionCulling && sceneFbo
+                           && useGpuCommands && indirectDraws.available();
+    if (occlusion) {
+        sceneFbo->bind();
+    }
+
+    drawScene(occlusion);
+
+    if (occlusion) {
+        FBO::unbind();
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFbo->id());
+        glBlitFramebuffer(0, 0, sceneFbo->width(), sceneFbo->height(),
+                          0, 0, sceneFbo->width(), sceneFbo->height(),
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+}
+
+void Viewer::drawScene(bool occlusion) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glPointSize(pointsSize);
 
     glPolygonMode(GL_FRONT_AND_BACK, gl_draw_mode(drawMode));
 
-    const auto& cpCount = vao->length();
+    {
+        FrameStats::Scope pass(frame_stats(), "updates");
+        shaders.update();
+        stream.drain(pool);
+    }
+
+    const auto& vao = pool.controlPoints().getVao();
+    const auto cpCount = static_cast<GLsizei>(pool.controlPoints().gpuSize());
+    if (cpCount == 0) {
+        hiZValid = false;
+        return;
+    }
 
     const auto& projMat = this->get_projection_matrix();
     const auto& mvMat = this->get_modelview_matrix();
 
-    bezierSurfaceShaderProgram->bind();
+    const GLMat4 mvp = projMat * mvMat;
+
+    // the pre-tessellated levels need the points on the CPU
+    if (useLod && lodShaderProgram && lod.update(pool)) {
+        FrameStats::Scope pass(frame_stats(), "lod surfaces");
+        lodShaderProgram->bind();
+        set_uniform_value("projMatrix", projMat);
+        set_uniform_value("mvMatrix", mvMat);
+        set_uniform_value("uColor", GLVec4(color));
+        lod.draw(projMat, mvMat, height(), lodPixels, frame_arena());
+        ShaderProgram::unbind();
+    } else {
+        FrameStats::Scope pass(frame_stats(), "tessellated surfaces");
+        // the pyramid of another model, or of frames drawn without it, would
+        // cull patches which are visible
+        const bool occluders = occlusion && hiZValid
+                               && hiZGeneration == pool.generation();
+        drawTessellated(projMat, mvMat, occluders);
+    }
+
+    // depth of the surfaces only, the control points are not occluders
+    if (occlusion) {
+        FrameStats::Scope pass(frame_stats(), "hi-z");
+        hiZ.build(*sceneFbo->depth_texture());
+        hiZMvp = mvp;
+        hiZGeneration = pool.generation();
+    }
+    hiZValid = occlusion;
 
-    set_uniform_value("projMatrix", projMat);
-    set_uniform_value("mvMatrix", mvMat);
-    set_uniform_value("uColor", GLVec4(color));
 
-    set_uniform_value("uLevel", static_cast<GLfloat>(tesselationLevel));
+    FrameStats::Scope pass(frame_stats(), "control points");
+    controlPointsShaderProgram->bind();
 
-    set_uniform_value("uCPUCount", dimU);
-    set_uniform_value("uCPVCount", dimV);
+    set_uniform_value("projMatrix", projMat);
+    set_uniform_value("mvMatrix", mvMat);
 
     vao->bind();
-    glPatchParameteri(GL_PATCH_VERTICES, cpCount);
-    glDrawArrays(GL_PATCHES, 0, cpCount);
+    glDrawArrays(GL_POINTS, 0, cpCount);
     vao->unbind();
 
-    bezierSurfaceShaderProgram->unbind();
-
-
-    transformablePointsShaderProgram->bind();
+    controlPointsShaderProgram->unbind();
+}
 
-    set_uniform_value("projMatrix", projMat);
-    set_uniform_value("mvMatrix", mvMat);
-    set_uniform_value("uColor", GLVec4({0., 1., 0., 1.}));
+void Viewer::drawTessellated(const GLMat4& projMat, const GLMat4& mvMat,
+                             bool occluders) {
+    batches.update(pool);
+    const bool gpuCommands = useGpuCommands && indirectDraws.available();
+    if (gpuCommands) {
+        indirectDraws.generate(pool, batches, projMat * mvMat,
+                               occluders ? &hiZ : nullptr, hiZMvp);
+    }
 
+    const auto& vao = pool.controlPoints().getVao();
     vao->bind();
-    glDrawArrays(GL_POINTS, 0, cpCount);
+    const ShaderProgram* bound = nullptr;
+    for (std::size_t i = 0; i < batches.batches().size(); ++i) {
+        const auto& batch = batches.batches()[i];
+        if (batch.isCurve()) {
+            continue;
+        }
+        const auto& program = bezierSurfaceShaders.get(
+                surfaceKey(batch.countU, batch.countV, spacing)
+        );
+        if (!program) {
+            continue;
+        }
+        if (program.get() != bound) {
+            program->bind();
+            bound = program.get();
+
+            set_uniform_value("projMatrix", projMat);
+            set_uniform_value("mvMatrix", mvMat);
+            set_uniform_value("uColor", GLVec4(color));
+            set_uniform_value("uLevel", tesselationLevel);
+            set_uniform_value("uAdaptive", adaptiveTessellation);
+            set_uniform_value("uSegmentPixels", segmentPixels);
+            set_uniform_value("uViewport", GLVec2(static_cast<float>(width()),
+                                                  static_cast<float>(height())));
+            set_uniform_value("uFrustumCulling", frustumCulling);
+            set_uniform_value("uBackPatchCulling", backPatchCulling);
+        }
+        // the spacing variants of the large patches are not specialized
+        if (program == bezierSurfaceShaders.generic()
+            || !specialized(batch.countU, batch.countV)) {
+            set_uniform_value("uCPUCount", batch.countU);
+            set_uniform_value("uCPVCount", batch.countV);
+        }
+        glPatchParameteri(GL_PATCH_VERTICES, batch.patchVertices());
+        if (gpuCommands) {
+            indirectDraws.draw(i);
+        } else {
+            batch.draw(GL_PATCHES);
+        }
+    }
     vao->unbind();
 
-    transformablePointsShaderProgram->unbind();
+    ShaderProgram::unbind();
 }
 
 void Viewer::interface_ogl() {
     bool ui_tesselation_level_show = true;
     ImGui::Begin("Parameters", &ui_tesselation_level_show);
 
+    if (ImGui::TreeNode("File")) {
+        if (ImGui::Button("Open")) {
+            const auto paths = pfd::open_file(
+                    "Open control net", "",
+                    {"Control nets", "*.cnet *.obj *.igs *.iges"}
+            ).result();
+            if (!paths.empty()) {
+                loadModel(paths.front());
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) {
+            const auto path = pfd::save_file(
+                    "Save control net", modelPath, {"Control nets", "*.cnet"}
+            ).result();
+            if (!path.empty() && ControlNetFile::write(path, pool)) {
+                modelPath = path;
+            }
+        }
+        if (ImGui::Button("Export mesh")) {
+            const auto path = pfd::save_file(
+                    "Export tessellated mesh", "",
+                    {"Meshes", "*.stl *.ply *.obj"}
+            ).result();
+            if (!path.empty()) {
+                MeshExportOptions options;
+                options.level = static_cast<GLuint>(std::ceil(tesselationLevel));
+                exportMesh(path, pool, options);
+            }
+        }
+
+        ImGui::TreePop();
+    }
+
     if (ImGui::TreeNode("Rendering")) {
         ImGui::SliderInt(
                 ("Draw Mode - " + to_string(drawMode)).c_str(),
                 reinterpret_cast<int*>(&drawMode),
                 0, 2
         );
+        if (indirectDraws.available()) {
+            ImGui::Checkbox("GPU culling and draw commands", &useGpuCommands);
+        }
+        if (sceneFbo) {
+            // hides what was hidden by the surfaces in the previous frame
+            ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+        }
+        ImGui::Checkbox("Frustum culling", &frustumCulling);
+        // open surfaces show their back side, only for closed models
+        ImGui::Checkbox("Back patch culling", &backPatchCulling);
+        ImGui::Checkbox("Pre-tessellated LOD", &useLod);
+        if (useLod) {
+            ImGui::SliderFloat("LOD segment pixels", &lodPixels, 1.f, 64.f);
+            const auto& drawn = lod.drawnCounts();
+            ImGui::Text("LOD vertices %.1f MB, patches per level %d/%d/%d/%d",
+                        static_cast<double>(lod.memory()) / (1024. * 1024.),
+                        drawn[0], drawn[1], drawn[2], drawn[3]);
+            ImGui::Text("Geometry buffer %.1f / %.1f MB, %zu free ranges",
+                        static_cast<double>(geometryBuffers.used()) / (1024. * 1024.),
+                        static_cast<double>(geometryBuffers.capacity()) / (1024. * 1024.),
+                        geometryBuffers.free_range_count());
+        }
         ImGui::ColorEdit4("Color", color);
         ImGui::SliderInt("CP Size", &pointsSize, 0, 40);
+        bool frameTimes = show_frame_stats();
+        if (ImGui::Checkbox("Frame times (F3)", &frameTimes)) {
+            set_show_frame_stats(frameTimes);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save trace (F4)")) {
+            save_trace();
+        }
 
         ImGui::TreePop();
     }
 
     if (ImGui::TreeNode("Parameters")) {
-        ImGui::SliderInt(
+        ImGui::TextUnformatted("Ctrl + click drags a control point");
+        ImGui::SliderFloat(
                 "Tesselation Level",
                 &tesselationLevel,
-                1, 50
+                1.f, 50.f
+        );
+        // the fractional spacings do not pop when the levels change
+        ImGui::SliderInt(
+                ("Spacing - " + to_string(spacing)).c_str(),
+                reinterpret_cast<int*>(&spacing),
+                0, 2
         );
+        // edge levels from their size on screen, matched between neighbours
+        ImGui::Checkbox("Adaptive tessellation", &adaptiveTessellation);
+        if (adaptiveTessellation) {
+            ImGui::SliderFloat("Segment pixels", &segmentPixels, 2.f, 50.f);
+        }
+        if (ImGui::Button("Check watertightness")) {
+            checkWatertight(pool, tessLevelParams(), watertightReport);
+            for (const auto& crack : watertightReport.cracks) {
+                std::cout << "Crack between patch " << crack.patchA
+                          << " (edge " << crack.edgeA << ", " << crack.segmentsA
+                          << " segments) and patch " << crack.patchB
+                          << " (edge " << crack.edgeB << ", " << crack.segmentsB
+                          << " segments), gap " << crack.gap << std::endl;
+            }
+        }
+        ImGui::Text("%zu shared edges, %zu open, %zu cracks",
+                    watertightReport.sharedEdges, watertightReport.openEdges,
+                    watertightReport.cracks.size());
 
         ImGui::TreePop();
     }
 
     ImGui::End();
 }
+
+TessLevelParams Viewer::tessLevelParams() const {
+    TessLevelParams params;
+    params.level = tesselationLevel;
+    params.adaptive = adaptiveTessellation;
+    params.mvp = get_projection_matrix() * get_modelview_matrix();
+    params.viewport = GLVec2(static_cast<float>(width()),
+                             static_cast<float>(height()));
+    params.segmentPixels = segmentPixels;
+    params.spacing = spacing;
+    return params;
+}
+
+void Viewer::setMovingSelected(bool selected) {
+    auto& points = pool.controlPoints();
+    for (const GLuint point : movingPoints) {
+        if (selected) {
+            points[point].flags |= CP_SELECTED;
+        } else {
+            points[point].flags &= ~CP_SELECTED;
+        }
+        points.update(point, 1);
+    }
+}
+
+void Viewer::mouse_press_ogl(int32_t button, double x, double y) {
+    // the points only live on the GPU for files opened without a copy
+    if (button != 0 || !control_pressed_ || !dependencies.update(pool)) {
+        GLViewer::mouse_press_ogl(button, x, y);
+        return;
+    }
+
+    const GLMat4 mvp = get_projection_matrix() * get_modelview_matrix();
+    const GLVec2 cursor(static_cast<float>(x), static_cast<float>(y));
+    const auto& points = pool.controlPoints().points();
+    float closest = PICK_RADIUS * PICK_RADIUS;
+    long int picked = -1;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const GLVec4 clip = mvp * GLVec4(points[i].position.x(), points[i].position.y(),
+                                         points[i].position.z(), 1.f);
+        if (clip.w() <= 0.f) {
+            continue;
+        }
+        const GLVec3 ndc = clip.head<3>() / clip.w();
+        const GLVec2 window((ndc.x() + 1.f) * width() / 2.f,
+                            (1.f - ndc.y()) * height() / 2.f);
+        const float distance = (window - cursor).squaredNorm();
+        if (distance < closest) {
+            closest = distance;
+            picked = static_cast<long int>(i);
+            movingDepth = ndc.z();
+        }
+    }
+    if (picked < 0) {
+        GLViewer::mouse_press_ogl(button, x, y);
+        return;
+    }
+
+    dependencies.coincident(static_cast<GLuint>(picked), movingPoints);
+    dependencies.patchesOf(movingPoints, movingPatches);
+    setMovingSelected(true);
+}
+
+void Viewer::mouse_release_ogl(int32_t button, double x, double y) {
+    if (movingPoints.empty()) {
+        GLViewer::mouse_release_ogl(button, x, y);
+        return;
+    }
+    setMovingSelected(false);
+    movingPoints.clear();
+    movingPatches.clear();
+}
+
+void Viewer::mouse_move_ogl(double x, double y) {
+    if (movingPoints.empty()) {
+        GLViewer::mouse_move_ogl(x, y);
+        return;
+    }
+
+    // the point stays at the same depth, under the cursor
+    const GLMat4 inverse = (get_projection_matrix() * get_modelview_matrix()).inverse();
+    const GLVec4 ndc(static_cast<float>(x) / width() * 2.f - 1.f,
+                     1.f - static_cast<float>(y) / height() * 2.f,
+                     movingDepth, 1.f);
+    const GLVec4 position = inverse * ndc;
+
+    // only the moved points and the patches using them are sent again
+    auto& points = pool.controlPoints();
+    for (const GLuint point : movingPoints) {
+        points[point].position = position.head<3>() / position.w();
+        points.update(point, 1);
+    }
+    lod.retessellate(pool, movingPatches);
+}
@@ -2,34 +2,96 @@
 #define BEZIER_VIEWER_HPP
 
 #include "easycppogl_src/gl_viewer.h"
+#include "easycppogl_src/fbo.h"
 #include "easycppogl_src/shader_program.h"
 
+#include "Benchmark.hpp"
 #include "utils.hpp"
+#include "HiZPyramid.hpp"
+#include "IndirectPatchDraws.hpp"
+#include "PatchBatches.hpp"
+#include "PatchDependencies.hpp"
+#include "PatchLod.hpp"
+#include "PatchPool.hpp"
+#include "PatchStream.hpp"
+#include "ShaderLibrary.hpp"
+#include "WatertightCheck.hpp"
 
 using namespace EZCOGL;
 
 class Viewer : public GLViewer {
 public:
-    Viewer();
+    explicit Viewer(const std::string& modelPath = "", bool visible = true);
     void init_ogl() override;
     void draw_ogl() override;
     void interface_ogl() override;
+    void resize_ogl(int32_t w, int32_t h) override;
+    void mouse_press_ogl(int32_t button, double x, double y) override;
+    void mouse_release_ogl(int32_t button, double x, double y) override;
+    void mouse_move_ogl(double x, double y) override;
+    void close_ogl() override;
+
+    /**
+     * Instead of launch3d: draw the frames of options offscreen (better in
+     * an invisible viewer) and measure them, one result per level.
+     */
+    bool runBenchmark(const BenchmarkOptions& options,
+                      std::vector<BenchmarkResult>& results);
 
 private:
-    void init_bezierSurfaces_vao();
+    void loadModel(const std::string& path);
+    void drawScene(bool occlusion);
+    void drawTessellated(const GLMat4& projMat, const GLMat4& mvMat,
+                         bool occluders);
+    void setMovingSelected(bool selected);
+    TessLevelParams tessLevelParams() const;
 
 private:
-    std::shared_ptr<ShaderProgram> bezierSurfaceShaderProgram;
-    std::shared_ptr<ShaderProgram> transformablePointsShaderProgram;
+    ShaderLibrary shaders;
+    // one variant per patch size and spacing, see surfaceKey
+    ShaderVariants bezierSurfaceShaders;
+    std::shared_ptr<ShaderProgram> controlPointsShaderProgram;
+    std::shared_ptr<ShaderProgram> lodShaderProgram;
+
+    PatchPool pool;
+    PatchBatches batches;
+    IndirectPatchDraws indirectDraws;
+    // suballocated by the objects drawing tessellated geometry
+    BufferPool geometryBuffers;
+    PatchLod lod;
+    PatchDependencies dependencies;
+    // depth of the previous frame, and the view it was rendered with
+    std::shared_ptr<FBO_DepthTexture> sceneFbo;
+    HiZPyramid hiZ;
+    PatchStream stream;
+    std::string modelPath;
 
-    std::shared_ptr<VAO> vao;
-    GLuint dimU;
-    GLuint dimV;
+    // point dragged with ctrl + click, its copies and the patches using them
+    std::vector<GLuint> movingPoints;
+    std::vector<GLuint> movingPatches;
+    // depth of the dragged point in normalized device coordinates
+    float movingDepth;
 
 private:
     DrawMode drawMode;
+    bool useGpuCommands;
+    bool frustumCulling;
+    bool backPatchCulling;
+    bool occlusionCulling;
+    GLMat4 hiZMvp;
+    // the pyramid holds the previous frame, of the model of this generation
+    bool hiZValid;
+    std::uint64_t hiZGeneration;
+    bool useLod;
+    // largest on screen length of a pre-tessellated segment
+    float lodPixels;
 
-    int tesselationLevel;
+    float tesselationLevel;
+    bool adaptiveTessellation;
+    TessSpacing spacing;
+    // on screen length of an adaptive segment
+    float segmentPixels;
+    WatertightReport watertightReport;
 
     float color[4];
     int pointsSize;
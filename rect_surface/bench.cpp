@@ -0,0 +1,91 @@
+/*
+ * Rendering benchmark of the surface viewer: draws a random net along a
+ * fixed camera path in an invisible window and prints the frame time
+ * percentiles, the GPU time and the tessellation evaluation invocations of
+ * each tessellation level. On a machine without a display (CI with llvmpipe)
+ * run it under xvfb-run.
+ *
+ *   rect_bench [--patches N] [--frames K] [--levels 1,4,16] [--seed S]
+ *              [--size WxH] [--json results.json]
+ */
+#include "Viewer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    void usage(const char* program) {
+        std::cerr << "Usage: " << program
+                  << " [--patches N] [--frames K] [--levels 1,4,16] [--seed S]"
+                     " [--size WxH] [--json results.json]" << std::endl;
+    }
+
+    bool parseLevels(const std::string& text, std::vector<float>& levels) {
+        levels.clear();
+        std::istringstream stream(text);
+        std::string level;
+        while (std::getline(stream, level, ',')) {
+            const float value = std::strtof(level.c_str(), nullptr);
+            if (value < 1.f) {
+                return false;
+            }
+            levels.push_back(value);
+        }
+        return !levels.empty();
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++i];
+
+        bool valid = true;
+        if (arg == "--patches") {
+            options.patchCount = std::strtoul(value.c_str(), nullptr, 10);
+            valid = options.patchCount > 0;
+        } else if (arg == "--frames") {
+            options.frames = std::strtoul(value.c_str(), nullptr, 10);
+            valid = options.frames > 0;
+        } else if (arg == "--levels") {
+            valid = parseLevels(value, options.levels);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--size") {
+            valid = std::sscanf(value.c_str(), "%dx%d", &options.width, &options.height) == 2
+                    && options.width > 0 && options.height > 0;
+        } else if (arg == "--json") {
+            jsonPath = value;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Viewer viewer("", false);
+    std::vector<BenchmarkResult> results;
+    if (!viewer.runBenchmark(options, results)) {
+        return EXIT_FAILURE;
+    }
+
+    printBenchmark(std::cout, options, results);
+    if (!jsonPath.empty()) {
+        const auto* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        if (!writeBenchmarkJson(jsonPath, options, renderer ? renderer : "", results)) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
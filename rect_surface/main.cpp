@@ -1,7 +1,7 @@
 #include "Viewer.hpp"
 
-int main() {
-    Viewer viewer;
+int main(int argc, char** argv) {
+    Viewer viewer(argc > 1 ? argv[1] : "");
     viewer.launch3d();
 
     return 0;
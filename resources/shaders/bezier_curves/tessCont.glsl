@@ -2,7 +2,12 @@
 
 #define MAX_CP 8
 
+// specialized variants output exactly the curve control points
+#ifdef CP_COUNT
+layout(vertices=CP_COUNT) out;
+#else
 layout(vertices=MAX_CP) out;
+#endif
 
 uniform float uOuterLevel0;
 uniform float uOuterLevel1;
@@ -1,40 +1,54 @@
 #version 410
 
-layout (isolines, equal_spacing) in;
+// SPACING, when defined, is the spacing of the vertices along the edges
+#ifndef SPACING
+#define SPACING equal_spacing
+#endif
+layout (isolines, SPACING) in;
 
 #define MAX_CP 8
 
+/* CP_COUNT, when defined, specializes the shader for one curve size: the
+ * loops have constant bounds and are unrolled. Otherwise the count is read
+ * from a uniform. */
+#ifdef CP_COUNT
+#if CP_COUNT > MAX_CP
+#error "curve too large"
+#endif
+#define CP CP_COUNT
+#define SIZE CP_COUNT
+#else
 uniform uint uCPCount;
+#define CP int(uCPCount)
+#define SIZE MAX_CP
+#endif
 
-vec4 deCasteljau(uint cp_count, float t);
+vec4 deCasteljau(float t);
 
 void main() {
-    if (uCPCount > 0 && uCPCount <= MAX_CP) {
-        gl_Position = deCasteljau(uCPCount, gl_TessCoord.x);
-    } else {
+#ifndef CP_COUNT
+    if (CP <= 0 || CP > MAX_CP) {
         gl_Position = vec4(0., 0., 0., 1.);
+        return;
     }
+#endif
+    vec4 point = deCasteljau(gl_TessCoord.x);
+    gl_Position = vec4(point.xyz / point.w, 1.0);
 }
 
-vec4 linearInterpolation(vec4 a, vec4 b, float t) {
-    return (1.0 - t) * a + t * b;
-}
-
-vec4 deCasteljau(uint cp_count, float t) {
-    vec4 points[MAX_CP];
-    uint points_count;
+/* control points are homogeneous (w x, w y, w z, w): the interpolation is
+ * projective and the division by w is done once on the result */
+vec4 deCasteljau(float t) {
+    vec4 points[SIZE];
 
-    for (uint i = 0; i < cp_count; ++i) {
+    for (int i = 0; i < CP; ++i) {
         points[i] = gl_in[i].gl_Position;
     }
-    points_count = cp_count;
 
-    while (points_count > 1) {
-        for (uint i = 0; i < points_count; ++i) {
-            points[i] = linearInterpolation(points[i], points[i + 1], t);
+    for (int n = CP - 1; n > 0; --n) {
+        for (int i = 0; i < n; ++i) {
+            points[i] = mix(points[i], points[i + 1], t);
         }
-
-        --points_count;
     }
 
     return points[0];
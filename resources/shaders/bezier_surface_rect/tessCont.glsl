@@ -1,19 +1,181 @@
 #version 410
 
+#define MAX_CP_U 8
+#define MAX_CP_V 8
 #define MAX_CP 32
+// GL_MAX_TESS_GEN_LEVEL is at least 64
+#define MAX_LEVEL 64.0
 
+// specialized variants output exactly the patch control points
+#ifdef CP_COUNT
+layout(vertices=CP_COUNT) out;
+#define CP_U CP_U_COUNT
+#define CP_V CP_V_COUNT
+#define SIZE CP_COUNT
+#else
 layout(vertices=MAX_CP) out;
+uniform uint uCPUCount;
+uniform uint uCPVCount;
+#define CP_U int(uCPUCount)
+#define CP_V int(uCPVCount)
+#define SIZE MAX_CP
+#endif
 
 uniform float uLevel;
+// edge levels from the projected size of the edges, see edgeLevel
+uniform bool uAdaptive;
+uniform float uSegmentPixels;
+uniform vec2 uViewport;
+
+uniform mat4 projMatrix;
+uniform mat4 mvMatrix;
+
+uniform bool uFrustumCulling;
+uniform bool uBackPatchCulling;
+
+float edgeLevel(int first, int stride, int count);
+bool outsideFrustum();
+bool facingAway();
 
 void main() {
-    gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
-
-    gl_TessLevelInner[0]
-        = gl_TessLevelInner[1]
-        = gl_TessLevelOuter[0]
-        = gl_TessLevelOuter[1]
-        = gl_TessLevelOuter[2]
-        = gl_TessLevelOuter[3]
-        = uLevel;
+    if (gl_InvocationID < gl_PatchVerticesIn) {
+        gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
+    }
+
+    if (gl_InvocationID == 0) {
+        // edges u = 0, v = 0, u = 1 and v = 1
+        vec4 outer = vec4(uLevel);
+        if (uAdaptive) {
+            outer = vec4(edgeLevel(0, 1, CP_V),
+                         edgeLevel(0, CP_V, CP_U),
+                         edgeLevel((CP_U - 1) * CP_V, 1, CP_V),
+                         edgeLevel(CP_V - 1, CP_V, CP_U));
+        }
+        // an outer level of 0 discards the patch before the evaluation
+        if ((uFrustumCulling && outsideFrustum())
+            || (uBackPatchCulling && facingAway())) {
+            outer = vec4(0.0);
+        }
+
+        gl_TessLevelOuter[0] = outer[0];
+        gl_TessLevelOuter[1] = outer[1];
+        gl_TessLevelOuter[2] = outer[2];
+        gl_TessLevelOuter[3] = outer[3];
+        gl_TessLevelInner[0] = max(outer[1], outer[3]);
+        gl_TessLevelInner[1] = max(outer[0], outer[2]);
+    }
+}
+
+bool lexicographicLess(vec4 a, vec4 b) {
+    for (int i = 0; i < 4; ++i) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return false;
+}
+
+/* level of the edge made of count control points from first, every stride:
+ * the number of segments of uSegmentPixels in its projected control polygon,
+ * which is longer than the edge. Not rounded, the fractional spacings move
+ * the vertices continuously with it. Adjacent patches have the same copies of
+ * the points of their common edge, maybe in the opposite order: reading them
+ * from the smaller end, and with precise arithmetic, both patches compute
+ * exactly the same level and no T-junction opens between them.
+ * TessLevels.cpp does the same on the CPU. */
+float edgeLevel(int first, int stride, int count) {
+    int last = first + (count - 1) * stride;
+    bool reversed = false;
+    for (int k = 0; k < count / 2; ++k) {
+        vec4 a = gl_in[first + k * stride].gl_Position;
+        vec4 b = gl_in[last - k * stride].gl_Position;
+        if (a != b) {
+            reversed = lexicographicLess(b, a);
+            break;
+        }
+    }
+    int start = reversed ? last : first;
+    int step = reversed ? -stride : stride;
+
+    mat4 mvp = projMatrix * mvMatrix;
+    precise float length = 0.0;
+    precise vec2 previous = vec2(0.0);
+    for (int k = 0; k < count; ++k) {
+        precise vec4 clip = mvp * gl_in[start + k * step].gl_Position;
+        if (clip.w <= 0.0) {
+            return MAX_LEVEL;
+        }
+        precise vec2 window = clip.xy / clip.w * 0.5 * uViewport;
+        if (k > 0) {
+            length += distance(window, previous);
+        }
+        previous = window;
+    }
+    return clamp(length / uSegmentPixels, 1.0, MAX_LEVEL);
+}
+
+/* the patch lies in the convex hull of its control points: it is out of
+ * view if they all are outside one of the planes of the frustum. The points
+ * are homogeneous (w x, w y, w z, w) with w > 0, which does not change the
+ * side of the planes they are on. */
+bool outsideFrustum() {
+    mat4 mvp = projMatrix * mvMatrix;
+    uint outside = 0x3fu;
+    for (int i = 0; i < gl_PatchVerticesIn; ++i) {
+        vec4 clip = mvp * gl_in[i].gl_Position;
+        outside &= (clip.x < -clip.w ? 0x01u : 0u)
+                 | (clip.x >  clip.w ? 0x02u : 0u)
+                 | (clip.y < -clip.w ? 0x04u : 0u)
+                 | (clip.y >  clip.w ? 0x08u : 0u)
+                 | (clip.z < -clip.w ? 0x10u : 0u)
+                 | (clip.z >  clip.w ? 0x20u : 0u);
+    }
+    return outside != 0u;
+}
+
+/* normal cone test: the derivatives along u and v are positive combinations
+ * of the differences of the control net along u and v, so every normal of
+ * the surface is a positive combination of their cross products. The patch
+ * faces away if all of them face away from the eye as seen from every
+ * control point. Only for polynomial patches (equal weights). */
+bool facingAway() {
+    if (CP_U < 2 || CP_V < 2 || CP_U * CP_V != gl_PatchVerticesIn) {
+        return false;
+    }
+
+    float weight = gl_in[0].gl_Position.w;
+    vec3 points[SIZE];
+    for (int i = 0; i < gl_PatchVerticesIn; ++i) {
+        if (gl_in[i].gl_Position.w != weight) {
+            return false;
+        }
+        points[i] = (mvMatrix * gl_in[i].gl_Position).xyz / weight;
+    }
+
+    // orthographic projection: the same view direction everywhere
+    bool orthographic = projMatrix[3][3] == 1.0;
+
+    for (int iu = 0; iu < CP_U - 1; ++iu) {
+        for (int iv = 0; iv < CP_V; ++iv) {
+            vec3 du = points[(iu + 1) * CP_V + iv] - points[iu * CP_V + iv];
+            for (int ju = 0; ju < CP_U; ++ju) {
+                for (int jv = 0; jv < CP_V - 1; ++jv) {
+                    vec3 normal = cross(du, points[ju * CP_V + jv + 1]
+                                            - points[ju * CP_V + jv]);
+                    if (orthographic) {
+                        if (normal.z >= 0.0) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    for (int i = 0; i < gl_PatchVerticesIn; ++i) {
+                        if (dot(normal, -points[i]) >= 0.0) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
 }
@@ -4,68 +4,76 @@
 #define MAX_CP_V 8
 #define MAX_CP 32
 
-layout (quads, equal_spacing, ccw) in;
-
+// SPACING, when defined, is the spacing of the vertices along the edges
+#ifndef SPACING
+#define SPACING equal_spacing
+#endif
+layout (quads, SPACING, ccw) in;
+
+/* CP_U_COUNT and CP_V_COUNT (and their product CP_COUNT, for the control
+ * shader layout), when defined, specialize the shader for one patch size:
+ * the loops have constant bounds and are unrolled. Otherwise the counts are
+ * read from uniforms. */
+#ifdef CP_U_COUNT
+#if CP_U_COUNT > MAX_CP_U || CP_V_COUNT > MAX_CP_V || CP_U_COUNT * CP_V_COUNT > MAX_CP
+#error "patch too large"
+#endif
+#define CP_U CP_U_COUNT
+#define CP_V CP_V_COUNT
+#define SIZE_U CP_U_COUNT
+#define SIZE_V CP_V_COUNT
+#else
 uniform uint uCPUCount;
 uniform uint uCPVCount;
+#define CP_U int(uCPUCount)
+#define CP_V int(uCPVCount)
+#define SIZE_U MAX_CP_U
+#define SIZE_V MAX_CP_V
+#endif
+
+uniform mat4 projMatrix;
+uniform mat4 mvMatrix;
 
 
-vec4 deCasteljau1D(vec4 cp[MAX_CP], uint cp_count,
-                   uint offset, uint stride, float t);
-vec4 deCasteljau2D(uint cp_u_count, uint cp_v_count, float u, float v);
+vec4 deCasteljau2D(float u, float v);
 
 
 void main() {
-    if (uCPUCount > 0 && uCPUCount <= MAX_CP_U
-        && uCPVCount > 0 && uCPVCount <= MAX_CP_V
-        && uCPVCount * uCPUCount <= MAX_CP) {
-        gl_Position = deCasteljau2D(
-            uCPUCount, uCPVCount,
-            gl_TessCoord.x, gl_TessCoord.y
-        );
-    } else {
+#ifndef CP_U_COUNT
+    if (CP_U <= 0 || CP_U > MAX_CP_U || CP_V <= 0 || CP_V > MAX_CP_V
+        || CP_U * CP_V > MAX_CP) {
         gl_Position = vec4(0., 0., 0., 1.);
+        return;
     }
+#endif
+    vec4 point = deCasteljau2D(gl_TessCoord.x, gl_TessCoord.y);
+    gl_Position = projMatrix * mvMatrix * vec4(point.xyz / point.w, 1.0);
 }
 
 
-vec4 linearInterpolation(vec4 a, vec4 b, float t) {
-    return (1.0 - t) * a + t * b;
-}
-
-
-vec4 deCasteljau2D(uint cp_u_count, uint cp_v_count, float u, float v) {
-    vec4 points[MAX_CP];
-
-    for (uint i = 0; i < cp_v_count * cp_u_count; ++i) {
-        points[i] = gl_in[i].gl_Position;
-    }
-
-    for (uint iu = 0; iu < cp_u_count; ++iu) {
-        points[iu] = deCasteljau1D(points, cp_v_count, iu * cp_v_count, 1, v);
-    }
-
-    return deCasteljau1D(points, cp_u_count, 0, 1, u);
-
-}
-
-vec4 deCasteljau1D(vec4 cp[MAX_CP], uint cp_count,
-                   uint offset, uint stride, float t) {
-    vec4 points[MAX_CP];
-    uint points_count;
+/* control points are homogeneous (w x, w y, w z, w): the interpolation is
+ * projective and the division by w is done once on the result */
+vec4 deCasteljau2D(float u, float v) {
+    vec4 row[SIZE_U];
 
-    for (uint i = 0; i < cp_count; ++i) {
-        points[i] = cp[offset + i * stride];
+    for (int iu = 0; iu < CP_U; ++iu) {
+        vec4 column[SIZE_V];
+        for (int iv = 0; iv < CP_V; ++iv) {
+            column[iv] = gl_in[iu * CP_V + iv].gl_Position;
+        }
+        for (int n = CP_V - 1; n > 0; --n) {
+            for (int i = 0; i < n; ++i) {
+                column[i] = mix(column[i], column[i + 1], v);
+            }
+        }
+        row[iu] = column[0];
     }
-    points_count = cp_count;
 
-    while (points_count > 1) {
-        for (uint i = 0; i < points_count; ++i) {
-            points[i] = linearInterpolation(points[i], points[i + 1], t);
+    for (int n = CP_U - 1; n > 0; --n) {
+        for (int i = 0; i < n; ++i) {
+            row[i] = mix(row[i], row[i + 1], u);
         }
-
-        --points_count;
     }
 
-    return points[0];
+    return row[0];
 }
@@ -0,0 +1,18 @@
+#version 410
+
+layout(location = 0) in vec4 iPosition;
+layout(location = 1) in vec4 iColor;
+layout(location = 2) in uint iFlags;
+
+uniform mat4 projMatrix;
+uniform mat4 mvMatrix;
+
+out vec4 vColor;
+
+const uint CP_SELECTED = 1u;
+const vec4 SELECTED_COLOR = vec4(1.0, 1.0, 0.0, 1.0);
+
+void main() {
+    vColor = (iFlags & CP_SELECTED) != 0u ? SELECTED_COLOR : iColor;
+    gl_Position = projMatrix * mvMatrix * vec4(iPosition.xyz, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 430
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// level 0 copies the depth texture, the next levels reduce the previous one
+uniform bool uFromDepth;
+uniform sampler2D uDepth;
+layout(r32f, binding = 0) uniform readonly image2D uSource;
+layout(r32f, binding = 1) uniform writeonly image2D uDestination;
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(uDestination);
+    if (any(greaterThanEqual(texel, size))) {
+        return;
+    }
+
+    if (uFromDepth) {
+        imageStore(uDestination, texel, vec4(texelFetch(uDepth, texel, 0).r));
+        return;
+    }
+
+    /* farthest depth of the source texels covered by this one: 2x2, 3 along
+     * an odd dimension so that the last row or column is not lost */
+    ivec2 sourceSize = imageSize(uSource);
+    ivec2 begin = texel * sourceSize / size;
+    ivec2 end = ((texel + 1) * sourceSize + size - 1) / size;
+    float farthest = 0.0;
+    for (int y = begin.y; y < end.y; ++y) {
+        for (int x = begin.x; x < end.x; ++x) {
+            farthest = max(farthest, imageLoad(uSource, ivec2(x, y)).r);
+        }
+    }
+    imageStore(uDestination, texel, vec4(farthest));
+}
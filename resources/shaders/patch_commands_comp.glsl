@@ -0,0 +1,99 @@
+#version 430
+
+layout(local_size_x = 64) in;
+
+// first control point and control point count of each patch, in batch order
+layout(std430, binding = 0) readonly buffer Patches {
+    uvec2 patches[];
+};
+
+// the control point VBO, read as floats: the position and weight of a point
+// are its first four floats
+layout(std430, binding = 1) readonly buffer ControlPoints {
+    float controlPoints[];
+};
+
+// DrawArraysIndirectCommand: count, instanceCount, first, baseInstance
+layout(std430, binding = 2) writeonly buffer Commands {
+    uvec4 commands[];
+};
+
+uniform mat4 uMvpMatrix;
+uniform uint uPatchCount;
+uniform uint uCPStride;
+
+// farthest depth pyramid of the previous frame, seen through uHiZMvpMatrix
+uniform bool uOcclusionCulling;
+uniform sampler2D uHiZ;
+uniform int uHiZLevels;
+uniform mat4 uHiZMvpMatrix;
+
+vec3 controlPoint(uint index) {
+    uint base = index * uCPStride;
+    return vec3(controlPoints[base], controlPoints[base + 1u], controlPoints[base + 2u]);
+}
+
+/* the patch is hidden if its nearest control point is farther than the
+ * farthest depth of the screen rectangle bounding its control points, read
+ * at the level where this rectangle covers at most 2x2 texels */
+bool occluded(uvec2 range) {
+    vec3 lower = vec3(1.0);
+    vec3 upper = vec3(-1.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        vec4 clip = uHiZMvpMatrix * vec4(controlPoint(range.x + i), 1.0);
+        if (clip.w <= 0.0) {
+            // crosses the eye plane, no meaningful rectangle
+            return false;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        lower = min(lower, ndc);
+        upper = max(upper, ndc);
+    }
+
+    vec2 lowerUv = clamp(lower.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 upperUv = clamp(upper.xy * 0.5 + 0.5, 0.0, 1.0);
+    float nearest = lower.z * 0.5 + 0.5;
+
+    vec2 pixels = (upperUv - lowerUv) * vec2(textureSize(uHiZ, 0));
+    int level = clamp(int(ceil(log2(max(max(pixels.x, pixels.y), 1.0)))),
+                      0, uHiZLevels - 1);
+    ivec2 size = textureSize(uHiZ, level);
+    ivec2 begin = ivec2(lowerUv * vec2(size));
+    ivec2 end = min(ivec2(upperUv * vec2(size)), size - 1);
+
+    float farthest = 0.0;
+    for (int y = begin.y; y <= end.y; ++y) {
+        for (int x = begin.x; x <= end.x; ++x) {
+            farthest = max(farthest, texelFetch(uHiZ, ivec2(x, y), level).r);
+        }
+    }
+    return nearest > farthest;
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uPatchCount) {
+        return;
+    }
+    uvec2 range = patches[index];
+
+    /* a patch lies in the convex hull of its control points (positive
+     * weights): it is out of view if they are all outside one of the planes
+     * of the frustum, tested in clip space */
+    uint outside = 0x3fu;
+    for (uint i = 0u; i < range.y; ++i) {
+        vec4 clip = uMvpMatrix * vec4(controlPoint(range.x + i), 1.0);
+        uint code = (clip.x < -clip.w ? 0x01u : 0u)
+                  | (clip.x >  clip.w ? 0x02u : 0u)
+                  | (clip.y < -clip.w ? 0x04u : 0u)
+                  | (clip.y >  clip.w ? 0x08u : 0u)
+                  | (clip.z < -clip.w ? 0x10u : 0u)
+                  | (clip.z >  clip.w ? 0x20u : 0u);
+        outside &= code;
+    }
+
+    bool visible = outside == 0u && !(uOcclusionCulling && occluded(range));
+
+    // culled patches stay in the buffer as empty draws
+    commands[index] = uvec4(range.y, visible ? 1u : 0u, range.x, 0u);
+}
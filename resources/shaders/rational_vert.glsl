@@ -0,0 +1,9 @@
+#version 410
+
+// xyz: position, w: rational weight
+layout(location = 0) in vec4 iPosition;
+
+void main() {
+    // homogeneous control point, projected back after evaluation
+    gl_Position = vec4(iPosition.xyz * iPosition.w, iPosition.w);
+}
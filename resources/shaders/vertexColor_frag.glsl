@@ -0,0 +1,9 @@
+#version 410
+
+in vec4 vColor;
+
+out vec4 oFragColor;
+
+void main() {
+    oFragColor = vec4(mix(vec3(0.0), vColor.rgb, vColor.a), 1.0);
+}